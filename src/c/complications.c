@@ -0,0 +1,163 @@
+#include "complications.h"
+
+typedef struct Slot {
+  TextLayer *layer;
+  ComplicationId id;
+  bool dirty;
+  time_t last_render;
+  const TextFit *fit;
+  int font_index;
+  char text[COMPLICATION_TEXT_SIZE];
+} Slot;
+
+static const Complication *s_table;
+static Slot s_slots[SlotCount];
+static int s_budget;
+static AppTimer *s_flush_timer;
+
+static void prv_schedule_flush(uint32_t delay_ms);
+
+/**
+ * Renders every dirty slot that is past its rate limit and fits the remaining
+ * budget. Rate-limited slots re-arm the flush timer for when they come due.
+ */
+static void prv_flush(void) {
+  time_t now = time(NULL);
+  time_t next_due = 0;
+
+  for (int slot_index = 0; slot_index < SlotCount; slot_index++) {
+    Slot *slot = &s_slots[slot_index];
+    if (!slot->dirty || !slot->layer || slot->id == ComplicationNone) {
+      continue;
+    }
+
+    const Complication *complication = &s_table[slot->id];
+    time_t due = slot->last_render + complication->min_interval_sec;
+    if (now < due) {
+      if (next_due == 0 || due < next_due) {
+        next_due = due;
+      }
+      continue;
+    }
+    if (s_budget < complication->cost) {
+      continue;
+    }
+
+    s_budget -= complication->cost;
+    complication->render(slot->text, sizeof(slot->text));
+    if (slot->fit) {
+      int font_index = text_fit(slot->fit, slot->text);
+      if (font_index != slot->font_index) {
+        text_layer_set_font(slot->layer, slot->fit->fonts[font_index]);
+        slot->font_index = font_index;
+      }
+    }
+    text_layer_set_text(slot->layer, slot->text);
+    slot->dirty = false;
+    slot->last_render = now;
+  }
+
+  if (next_due != 0) {
+    prv_schedule_flush((uint32_t)(next_due - now) * 1000);
+  }
+}
+
+static void flush_timer_callback(void *context) {
+  s_flush_timer = NULL;
+  prv_flush();
+}
+
+static void prv_schedule_flush(uint32_t delay_ms) {
+  if (s_flush_timer) {
+    app_timer_reschedule(s_flush_timer, delay_ms);
+  } else {
+    s_flush_timer = app_timer_register(delay_ms, flush_timer_callback, NULL);
+  }
+}
+
+void complications_init(const Complication *table) {
+  s_table = table;
+  s_budget = COMPLICATION_BUDGET_PER_MINUTE;
+  for (int slot_index = 0; slot_index < SlotCount; slot_index++) {
+    s_slots[slot_index] = (Slot) { .id = ComplicationNone, .font_index = -1 };
+  }
+}
+
+void complications_deinit(void) {
+  if (s_flush_timer) {
+    app_timer_cancel(s_flush_timer);
+    s_flush_timer = NULL;
+  }
+}
+
+void complications_place(SlotId slot_id, ComplicationId id, TextLayer *layer) {
+  Slot *slot = &s_slots[slot_id];
+  if (id >= ComplicationCount || !s_table[id].render) {
+    id = ComplicationNone;
+  }
+
+  slot->layer = layer;
+  if (slot->id == id && layer) {
+    // Same content, e.g. a colour change: keep the text and rate limit
+    return;
+  }
+
+  slot->id = id;
+  slot->text[0] = '\0';
+  slot->last_render = 0;
+  slot->dirty = id != ComplicationNone;
+  if (layer) {
+    text_layer_set_text(layer, slot->text);
+  }
+  if (slot->dirty) {
+    prv_schedule_flush(0);
+  }
+}
+
+void complications_set_fit(SlotId slot_id, const TextFit *fit) {
+  s_slots[slot_id].fit = fit;
+  s_slots[slot_id].font_index = -1;
+}
+
+int complications_slot_of(ComplicationId id) {
+  for (int slot_index = 0; slot_index < SlotCount; slot_index++) {
+    if (s_slots[slot_index].id == id) {
+      return slot_index;
+    }
+  }
+  return -1;
+}
+
+bool complications_is_placed(ComplicationId id) {
+  return complications_slot_of(id) >= 0;
+}
+
+void complications_mark_dirty(ComplicationId id) {
+  bool marked = false;
+  for (int slot_index = 0; slot_index < SlotCount; slot_index++) {
+    if (s_slots[slot_index].id == id) {
+      s_slots[slot_index].dirty = true;
+      marked = true;
+    }
+  }
+  if (marked) {
+    prv_schedule_flush(0);
+  }
+}
+
+void complications_minute_tick(time_t now) {
+  s_budget = COMPLICATION_BUDGET_PER_MINUTE;
+
+  for (int slot_index = 0; slot_index < SlotCount; slot_index++) {
+    Slot *slot = &s_slots[slot_index];
+    if (slot->id == ComplicationNone) {
+      continue;
+    }
+    const Complication *complication = &s_table[slot->id];
+    if (complication->is_stale && complication->is_stale(now)) {
+      slot->dirty = true;
+    }
+  }
+
+  prv_flush();
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <pebble.h>
+
+#include "text_fit.h"
+
+// Budget units a minute may spend on re-rendering slots. Dirty slots that do
+// not fit wait for the next minute tick.
+#define COMPLICATION_BUDGET_PER_MINUTE 90
+#define COMPLICATION_TEXT_SIZE 40
+
+// Values are stored in settings and sent by Clay, so only append.
+typedef enum ComplicationId {
+  ComplicationNone,
+  ComplicationHeartRate,
+  ComplicationWeather,
+  ComplicationSun,
+  ComplicationDate,
+  ComplicationBattery,
+  ComplicationSteps,
+  ComplicationSecondTime,
+  ComplicationCount
+} ComplicationId;
+
+typedef enum SlotId {
+  SlotTop,
+  SlotLower,
+  SlotBottom,
+  SlotCount
+} SlotId;
+
+typedef struct Complication {
+  // Writes the current text. Only called while the complication is placed.
+  void (*render)(char *buffer, size_t size);
+  // Optional cheap check, polled on each minute tick, for time-driven data.
+  bool (*is_stale)(time_t now);
+  // Minimum spacing between two renders of the same slot.
+  uint16_t min_interval_sec;
+  // Budget units charged per render.
+  uint8_t cost;
+} Complication;
+
+/**
+ * Registers the complication table, indexed by ComplicationId. The table must
+ * outlive the scheduler.
+ */
+void complications_init(const Complication *table);
+
+void complications_deinit(void);
+
+/**
+ * Binds a complication to a slot's TextLayer and queues its first render.
+ * ComplicationNone clears the slot, as do complications compiled out of this
+ * platform's feature profile (no render function in the table).
+ */
+void complications_place(SlotId slot, ComplicationId id, TextLayer *layer);
+
+/**
+ * Fits each render of the slot to a width by font and abbreviation. The fit
+ * is read on every render, so its width may change between renders; NULL
+ * keeps the layer's font.
+ */
+void complications_set_fit(SlotId slot, const TextFit *fit);
+
+/**
+ * Returns the slot showing the complication, or -1 when it is not placed.
+ */
+int complications_slot_of(ComplicationId id);
+
+bool complications_is_placed(ComplicationId id);
+
+/**
+ * Flags the slots showing the complication for re-rendering. A no-op when it
+ * is not placed. Renders are coalesced into a single deferred flush.
+ */
+void complications_mark_dirty(ComplicationId id);
+
+/**
+ * Refills the render budget, polls is_stale and flushes dirty slots.
+ */
+void complications_minute_tick(time_t now);
@@ -0,0 +1,315 @@
+#include "hr_analytics.h"
+
+#include <string.h>
+
+static uint8_t prv_clamp_bpm(int32_t bpm) {
+  if (bpm < 0) {
+    return 0;
+  }
+  return bpm > UINT8_MAX ? UINT8_MAX : (uint8_t)bpm;
+}
+
+/**
+ * Returns the median of a small array. The input is copied so the caller's
+ * ring order is preserved; insertion sort is fine for a handful of values.
+ */
+static int32_t prv_median(const int32_t *values, int count) {
+  int32_t sorted[HR_OUTLIER_RING_SIZE];
+
+  for (int index = 0; index < count; index++) {
+    int32_t value = values[index];
+    int insert = index;
+    while (insert > 0 && sorted[insert - 1] > value) {
+      sorted[insert] = sorted[insert - 1];
+      insert--;
+    }
+    sorted[insert] = value;
+  }
+
+  return sorted[count / 2];
+}
+
+void hr_outlier_filter_init(HrOutlierFilter *filter) {
+  memset(filter, 0, sizeof(*filter));
+}
+
+bool hr_outlier_filter_accept(HrOutlierFilter *filter, int32_t bpm) {
+  filter->ring[filter->head] = bpm;
+  filter->head = (filter->head + 1) % HR_OUTLIER_RING_SIZE;
+  if (filter->count < HR_OUTLIER_RING_SIZE) {
+    filter->count++;
+  }
+
+  // Not enough history yet to tell a spike from a trend
+  if (filter->count < 3) {
+    return true;
+  }
+
+  int32_t median = prv_median(filter->ring, filter->count);
+
+  int32_t deviations[HR_OUTLIER_RING_SIZE];
+  for (int index = 0; index < filter->count; index++) {
+    int32_t deviation = filter->ring[index] - median;
+    deviations[index] = deviation < 0 ? -deviation : deviation;
+  }
+  int32_t mad = prv_median(deviations, filter->count);
+
+  // 3 sigma with sigma ~= 1.5 * MAD, floored so a flat ring still tolerates
+  // normal beat-to-beat variation
+  int32_t limit = (mad * 9) / 2;
+  if (limit < HR_OUTLIER_MIN_JUMP_BPM) {
+    limit = HR_OUTLIER_MIN_JUMP_BPM;
+  }
+
+  int32_t jump = bpm - median;
+  if (jump < 0) {
+    jump = -jump;
+  }
+  if (jump > limit) {
+    filter->rejected++;
+    return false;
+  }
+
+  return true;
+}
+
+void hr_window_init(HrWindow *window, uint32_t max_age_sec) {
+  memset(window, 0, sizeof(*window));
+  window->max_age_sec = max_age_sec;
+}
+
+static uint16_t prv_window_oldest(const HrWindow *window) {
+  return (window->head + HR_SAMPLE_BUFFER_SIZE - window->count) % HR_SAMPLE_BUFFER_SIZE;
+}
+
+/**
+ * Adds (sign = 1) or removes (sign = -1) one sample from the running sums.
+ */
+static void prv_window_update_sums(HrWindow *window, uint32_t time, int32_t value, int sign) {
+  int64_t t = (int64_t)time - (int64_t)window->origin;
+  int64_t y = value;
+
+  window->sum_t += sign * t;
+  window->sum_y += sign * y;
+  window->sum_tt += sign * t * t;
+  window->sum_ty += sign * t * y;
+}
+
+static void prv_window_drop_oldest(HrWindow *window) {
+  uint16_t oldest = prv_window_oldest(window);
+  prv_window_update_sums(window, window->times[oldest], window->values[oldest], -1);
+  window->count--;
+}
+
+/**
+ * Moves the time origin forward to the oldest sample once it drifts too far,
+ * shifting the sums in O(1) instead of re-accumulating them. An empty window
+ * restarts the sums at the incoming sample time.
+ */
+static void prv_window_rebase(HrWindow *window, uint32_t now) {
+  if (window->count == 0) {
+    window->origin = now;
+    window->sum_t = window->sum_y = window->sum_tt = window->sum_ty = 0;
+    return;
+  }
+
+  uint32_t oldest_time = window->times[prv_window_oldest(window)];
+  int64_t shift = (int64_t)oldest_time - (int64_t)window->origin;
+  if (shift < HR_SLOPE_REBASE_SEC) {
+    return;
+  }
+
+  int64_t n = window->count;
+  window->sum_tt += (n * shift * shift) - (2 * shift * window->sum_t);
+  window->sum_ty -= shift * window->sum_y;
+  window->sum_t -= n * shift;
+  window->origin = oldest_time;
+}
+
+void hr_window_push(HrWindow *window, uint32_t now, int32_t bpm) {
+  while (window->count > 0 &&
+         (now - window->times[prv_window_oldest(window)]) > window->max_age_sec) {
+    prv_window_drop_oldest(window);
+  }
+  if (window->count >= HR_SAMPLE_BUFFER_SIZE) {
+    prv_window_drop_oldest(window);
+  }
+
+  uint8_t value = prv_clamp_bpm(bpm);
+  prv_window_rebase(window, now);
+  prv_window_update_sums(window, now, value, 1);
+
+  window->times[window->head] = now;
+  window->values[window->head] = value;
+  window->head = (window->head + 1) % HR_SAMPLE_BUFFER_SIZE;
+  window->count++;
+}
+
+int32_t hr_window_slope_per_min(const HrWindow *window) {
+  if (window->count < 3) {
+    return 0;
+  }
+
+  uint32_t oldest_time = window->times[prv_window_oldest(window)];
+  uint32_t newest_time =
+      window->times[(window->head + HR_SAMPLE_BUFFER_SIZE - 1) % HR_SAMPLE_BUFFER_SIZE];
+  if ((newest_time - oldest_time) < HR_SLOPE_MIN_SPAN_SEC) {
+    return 0;
+  }
+
+  int64_t n = window->count;
+  int64_t numerator = (n * window->sum_ty) - (window->sum_t * window->sum_y);
+  int64_t denominator = (n * window->sum_tt) - (window->sum_t * window->sum_t);
+  if (denominator <= 0) {
+    return 0;
+  }
+
+  // Round to nearest while scaling BPM/s to BPM/min
+  int64_t scaled = numerator * 60;
+  int64_t half = denominator / 2;
+  return (int32_t)((scaled >= 0 ? scaled + half : scaled - half) / denominator);
+}
+
+int32_t hr_window_mean(const HrWindow *window) {
+  if (window->count == 0) {
+    return 0;
+  }
+  return (int32_t)(window->sum_y / window->count);
+}
+
+/**
+ * Folds one block summary into another. An empty source is a no-op.
+ */
+static void prv_merge_block(HrBlock *into, const HrBlock *from) {
+  if (from->count == 0) {
+    return;
+  }
+
+  if (into->count == 0 || from->min < into->min) {
+    into->min = from->min;
+  }
+  if (into->count == 0 || from->max > into->max) {
+    into->max = from->max;
+  }
+  into->sum += from->sum;
+  into->count += from->count;
+}
+
+/**
+ * Closes the current 10 s block by merging it into its minute block, resetting
+ * the minute slot first if it still holds an older minute.
+ */
+static void prv_close_block(HrBlockWindows *blocks) {
+  HrBlock *block = &blocks->ten_sec[blocks->current_id % HR_BLOCKS_PER_MINUTE];
+  uint32_t minute_id = blocks->current_id / HR_BLOCKS_PER_MINUTE;
+  HrBlock *minute = &blocks->minute[minute_id % HR_MINUTE_BLOCK_COUNT];
+
+  if (minute->id != minute_id) {
+    *minute = (HrBlock) { .id = minute_id };
+  }
+  prv_merge_block(minute, block);
+}
+
+void hr_blocks_init(HrBlockWindows *blocks) {
+  memset(blocks, 0, sizeof(*blocks));
+}
+
+bool hr_blocks_add(HrBlockWindows *blocks, uint32_t now, int32_t bpm,
+                   HrBlock *finished_minute, uint32_t *skipped_minutes) {
+  uint32_t block_id = now / HR_BLOCK_SEC;
+  bool minute_finished = false;
+
+  if (block_id != blocks->current_id) {
+    if (blocks->current_id != 0) {
+      prv_close_block(blocks);
+
+      uint32_t old_minute = blocks->current_id / HR_BLOCKS_PER_MINUTE;
+      uint32_t new_minute = block_id / HR_BLOCKS_PER_MINUTE;
+      if (new_minute != old_minute) {
+        *finished_minute = blocks->minute[old_minute % HR_MINUTE_BLOCK_COUNT];
+        *skipped_minutes = new_minute - old_minute - 1;
+        minute_finished = true;
+      }
+    }
+    blocks->current_id = block_id;
+    blocks->ten_sec[block_id % HR_BLOCKS_PER_MINUTE] = (HrBlock) { .id = block_id };
+  }
+
+  uint8_t value = prv_clamp_bpm(bpm);
+  HrBlock sample = { .id = block_id, .sum = value, .min = value, .max = value, .count = 1 };
+  prv_merge_block(&blocks->ten_sec[block_id % HR_BLOCKS_PER_MINUTE], &sample);
+  return minute_finished;
+}
+
+HrBlock hr_blocks_query(const HrBlockWindows *blocks, uint32_t window_sec) {
+  uint32_t current_id = blocks->current_id;
+  HrBlock result = { .id = current_id };
+
+  if (window_sec <= HR_BLOCK_SEC * HR_BLOCKS_PER_MINUTE) {
+    uint32_t count = window_sec / HR_BLOCK_SEC;
+    for (uint32_t index = 0; index < count && index <= current_id; index++) {
+      const HrBlock *block = &blocks->ten_sec[(current_id - index) % HR_BLOCKS_PER_MINUTE];
+      if (block->id == current_id - index) {
+        prv_merge_block(&result, block);
+      }
+    }
+    return result;
+  }
+
+  // The open block has not been rolled into its minute yet
+  const HrBlock *open_block = &blocks->ten_sec[current_id % HR_BLOCKS_PER_MINUTE];
+  if (open_block->id == current_id) {
+    prv_merge_block(&result, open_block);
+  }
+
+  uint32_t current_minute = current_id / HR_BLOCKS_PER_MINUTE;
+  uint32_t minutes = window_sec / 60;
+  if (minutes > HR_MINUTE_BLOCK_COUNT) {
+    minutes = HR_MINUTE_BLOCK_COUNT;
+  }
+  for (uint32_t index = 0; index < minutes && index <= current_minute; index++) {
+    const HrBlock *block = &blocks->minute[(current_minute - index) % HR_MINUTE_BLOCK_COUNT];
+    if (block->id == current_minute - index) {
+      prv_merge_block(&result, block);
+    }
+  }
+  return result;
+}
+
+uint32_t hr_block_spread(const HrBlock *block) {
+  return block->count < 2 ? 0 : (uint32_t)(block->max - block->min);
+}
+
+int32_t hr_block_mean(const HrBlock *block) {
+  return block->count > 0 ? (int32_t)(block->sum / block->count) : 0;
+}
+
+HrZone hr_zone_classify(int32_t bpm, int32_t baseline_bpm) {
+  int32_t elevated = HR_ZONE_ELEVATED_DEFAULT_BPM;
+  int32_t high = HR_ZONE_HIGH_DEFAULT_BPM;
+  if (baseline_bpm > 0) {
+    elevated = (baseline_bpm * HR_ZONE_ELEVATED_PCT) / 100;
+    high = (baseline_bpm * HR_ZONE_HIGH_PCT) / 100;
+  }
+
+  if (bpm >= high) {
+    return HrZoneHigh;
+  }
+  return bpm >= elevated ? HrZoneElevated : HrZoneRest;
+}
+
+void hr_zone_clock_add(HrZoneClock *clock, uint32_t now, int32_t bpm, int32_t baseline_bpm) {
+  if (clock->last_time > 0 && now > clock->last_time &&
+      (now - clock->last_time) <= HR_ZONE_MAX_GAP_SEC) {
+    clock->seconds[clock->last_zone] += now - clock->last_time;
+  }
+  clock->last_zone = (uint8_t)hr_zone_classify(bpm, baseline_bpm);
+  clock->last_time = now;
+}
+
+int32_t hr_percent_above_baseline(int32_t bpm, int32_t baseline_bpm) {
+  if (baseline_bpm <= 0) {
+    return 0;
+  }
+  return ((bpm - baseline_bpm) * 100) / baseline_bpm;
+}
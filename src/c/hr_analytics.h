@@ -0,0 +1,137 @@
+#pragma once
+
+// Fixed-point heart-rate analytics. Everything here works on caller-owned
+// structs with no allocation and no Pebble SDK dependency, so the same code
+// builds for every watch platform and for a Linux host.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define HR_SAMPLE_BUFFER_SIZE 96
+#define HR_OUTLIER_RING_SIZE 5
+#define HR_OUTLIER_MIN_JUMP_BPM 15
+#define HR_SLOPE_MIN_SPAN_SEC 15
+#define HR_SLOPE_REBASE_SEC 3600
+#define HR_BLOCK_SEC 10
+#define HR_BLOCKS_PER_MINUTE 6
+#define HR_MINUTE_BLOCK_COUNT 5
+#define HR_ZONE_ELEVATED_PCT 120
+#define HR_ZONE_HIGH_PCT 150
+#define HR_ZONE_ELEVATED_DEFAULT_BPM 100
+#define HR_ZONE_HIGH_DEFAULT_BPM 130
+#define HR_ZONE_MAX_GAP_SEC 60
+
+// Streaming Hampel filter over a tiny ring of the most recent raw readings.
+typedef struct HrOutlierFilter {
+  int32_t ring[HR_OUTLIER_RING_SIZE];
+  uint8_t head;
+  uint8_t count;
+  uint32_t rejected;
+} HrOutlierFilter;
+
+// Time-bounded ring of raw samples with running least-squares sums. Times are
+// seconds relative to origin so the 64-bit sums stay small.
+typedef struct HrWindow {
+  uint32_t times[HR_SAMPLE_BUFFER_SIZE];
+  uint8_t values[HR_SAMPLE_BUFFER_SIZE];
+  uint16_t head;
+  uint16_t count;
+  uint32_t max_age_sec;
+  uint32_t origin;
+  int64_t sum_t;
+  int64_t sum_y;
+  int64_t sum_tt;
+  int64_t sum_ty;
+} HrWindow;
+
+// Min/max/sum summary of the HR samples in one aligned time block. The id is
+// the block's start time divided by its length, so stale ring slots are
+// recognised without clearing them.
+typedef struct HrBlock {
+  uint32_t id;
+  uint32_t sum;
+  uint16_t count;
+  uint8_t min;
+  uint8_t max;
+} HrBlock;
+
+// Hierarchical window aggregates: the open 10 s block plus the previous ones,
+// and per-minute blocks built by merging each 10 s block as it closes.
+typedef struct HrBlockWindows {
+  HrBlock ten_sec[HR_BLOCKS_PER_MINUTE];
+  HrBlock minute[HR_MINUTE_BLOCK_COUNT];
+  uint32_t current_id;
+} HrBlockWindows;
+
+typedef enum HrZone {
+  HrZoneRest,
+  HrZoneElevated,
+  HrZoneHigh,
+  HrZoneCount
+} HrZone;
+
+// Seconds per zone, charged to the zone of the previous sample.
+typedef struct HrZoneClock {
+  uint32_t seconds[HrZoneCount];
+  uint32_t last_time;
+  uint8_t last_zone;
+} HrZoneClock;
+
+void hr_outlier_filter_init(HrOutlierFilter *filter);
+
+/**
+ * Feeds one raw reading. Returns false when it deviates from the ring median
+ * by more than the scaled MAD; a sustained step is accepted once it fills
+ * more than half the ring.
+ */
+bool hr_outlier_filter_accept(HrOutlierFilter *filter, int32_t bpm);
+
+void hr_window_init(HrWindow *window, uint32_t max_age_sec);
+
+/**
+ * Adds a sample, first dropping samples older than max_age_sec and the oldest
+ * one when the ring is full. O(1) amortised.
+ */
+void hr_window_push(HrWindow *window, uint32_t now, int32_t bpm);
+
+/**
+ * Least-squares slope in signed BPM per minute, or 0 until the window holds
+ * three samples spanning at least HR_SLOPE_MIN_SPAN_SEC.
+ */
+int32_t hr_window_slope_per_min(const HrWindow *window);
+
+int32_t hr_window_mean(const HrWindow *window);
+
+void hr_blocks_init(HrBlockWindows *blocks);
+
+/**
+ * Adds a sample to the open 10 s block. When the sample starts a new minute,
+ * the finished minute is copied to finished_minute, the number of empty
+ * minutes in between to skipped_minutes, and true is returned.
+ */
+bool hr_blocks_add(HrBlockWindows *blocks, uint32_t now, int32_t bpm,
+                   HrBlock *finished_minute, uint32_t *skipped_minutes);
+
+/**
+ * Summarises the most recent window_sec seconds, aligned to block boundaries.
+ * Each query touches at most a handful of blocks.
+ */
+HrBlock hr_blocks_query(const HrBlockWindows *blocks, uint32_t window_sec);
+
+uint32_t hr_block_spread(const HrBlock *block);
+
+int32_t hr_block_mean(const HrBlock *block);
+
+/**
+ * Zone for a BPM value, relative to the resting baseline when one is known
+ * (baseline_bpm > 0) and fixed defaults otherwise.
+ */
+HrZone hr_zone_classify(int32_t bpm, int32_t baseline_bpm);
+
+/**
+ * Charges the time since the previous sample to that sample's zone. Gaps
+ * longer than HR_ZONE_MAX_GAP_SEC count as missing data.
+ */
+void hr_zone_clock_add(HrZoneClock *clock, uint32_t now, int32_t bpm, int32_t baseline_bpm);
+
+int32_t hr_percent_above_baseline(int32_t bpm, int32_t baseline_bpm);
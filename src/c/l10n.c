@@ -0,0 +1,81 @@
+#include "l10n.h"
+
+#define L10N_VERSION 1
+#define L10N_HEADER_SIZE 4
+#define L10N_ENTRY_SIZE 6
+
+static char s_block[L10N_BLOCK_MAX];
+static const char *s_strings[L10nCount];
+
+static void prv_clear(void) {
+  s_block[0] = '\0';
+  for (int index = 0; index < L10nCount; index++) {
+    s_strings[index] = s_block;
+  }
+}
+
+static uint16_t prv_read_u16(const uint8_t *bytes) {
+  return (uint16_t)(bytes[0] | (bytes[1] << 8));
+}
+
+bool l10n_load(const char *language) {
+  prv_clear();
+
+  ResHandle handle = resource_get_handle(RESOURCE_ID_STRINGS);
+  uint8_t header[L10N_HEADER_SIZE];
+  if (resource_load_byte_range(handle, 0, header, sizeof(header)) != sizeof(header) ||
+      header[0] != L10N_VERSION || header[1] == 0 || header[2] != L10nCount) {
+    return false;
+  }
+
+  // Walk the directory one entry at a time; only the matching block is read
+  uint8_t entry[L10N_ENTRY_SIZE];
+  uint8_t chosen[L10N_ENTRY_SIZE];
+  for (int index = 0; index < header[1]; index++) {
+    uint32_t entry_offset = L10N_HEADER_SIZE + (index * L10N_ENTRY_SIZE);
+    if (resource_load_byte_range(handle, entry_offset, entry, sizeof(entry)) != sizeof(entry)) {
+      return false;
+    }
+    bool match = language && entry[0] == language[0] && entry[1] == language[1];
+    if (index == 0 || match) {
+      memcpy(chosen, entry, sizeof(chosen));
+    }
+    if (match) {
+      break;
+    }
+  }
+
+  uint16_t offset = prv_read_u16(&chosen[2]);
+  uint16_t length = prv_read_u16(&chosen[4]);
+  if (length == 0 || length > sizeof(s_block) ||
+      resource_load_byte_range(handle, offset, (uint8_t *)s_block, length) != length ||
+      s_block[length - 1] != '\0') {
+    prv_clear();
+    return false;
+  }
+
+  // Index the NUL-separated strings
+  const char *cursor = s_block;
+  const char *end = s_block + length;
+  for (int index = 0; index < L10nCount; index++) {
+    if (cursor >= end) {
+      prv_clear();
+      return false;
+    }
+    s_strings[index] = cursor;
+    cursor += strlen(cursor) + 1;
+  }
+  return true;
+}
+
+const char *l10n_get(L10nString id) {
+  return id < L10nCount ? s_strings[id] : "";
+}
+
+const char *const *l10n_day_names(void) {
+  return &s_strings[L10nDayFirst];
+}
+
+const char *const *l10n_month_names(void) {
+  return &s_strings[L10nMonthFirst];
+}
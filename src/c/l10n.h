@@ -0,0 +1,44 @@
+#pragma once
+
+#include <pebble.h>
+
+// Largest single-language block in the STRINGS resource
+#define L10N_BLOCK_MAX 256
+
+// Order must match tools/pack_strings.py.
+typedef enum L10nString {
+  L10nDayFirst,
+  L10nMonthFirst = L10nDayFirst + 7,
+  L10nConditionFirst = L10nMonthFirst + 12,
+  L10nConditionClear = L10nConditionFirst,
+  L10nConditionCloudy,
+  L10nConditionFog,
+  L10nConditionDrizzle,
+  L10nConditionFreezingDrizzle,
+  L10nConditionRain,
+  L10nConditionFreezingRain,
+  L10nConditionSnow,
+  L10nConditionSnowGrains,
+  L10nConditionShowers,
+  L10nConditionSnowShowers,
+  L10nConditionThunderstorm,
+  L10nConditionUnknown,
+  L10nLoading,
+  L10nCount
+} L10nString;
+
+/**
+ * Loads the strings of one language from the STRINGS resource with a single
+ * byte-range read. Unknown codes fall back to the first packed language.
+ * Returns false, leaving every string empty, if the resource is malformed.
+ */
+bool l10n_load(const char *language);
+
+const char *l10n_get(L10nString id);
+
+/**
+ * Day names indexed by tm_wday and month names indexed by tm_mon, for
+ * time_format_date.
+ */
+const char *const *l10n_day_names(void);
+const char *const *l10n_month_names(void);
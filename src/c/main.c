@@ -1,11 +1,75 @@
 #include <pebble.h>
-
-// Persistent storage key
+#include "features.auto.h"
+#include "hr_analytics.h"
+#include "solar.h"
+#include "complications.h"
+#include "time_format.h"
+#include "l10n.h"
+#include "text_fit.h"
+#include "power.h"
+#include "phone_link.h"
+#include "time_sprites.h"
+
+// Persistent storage keys
 #define SETTINGS_KEY 1
+#define BASELINE_KEY 2
+#define ZONES_KEY 3
+#define LOCATION_KEY 4
+#define SECOND_ZONE_KEY 5
+#define WEATHER_KEY 6
+#define HR_LOG_FIRST_KEY 10
 #define HR_ALERT_DELTA_BPM 30
 #define HR_ALERT_WINDOW_SEC 60
-#define HR_SAMPLE_BUFFER_SIZE 96
 #define HR_FAST_SAMPLE_PERIOD_SEC 1
+#define HR_IDLE_SAMPLE_PERIOD_SEC 10
+#define HR_ALERT_SLOPE_BPM_PER_MIN 20
+#define HR_SHORT_WINDOW_SEC 10
+#define HR_LONG_WINDOW_SEC 300
+#define STAND_WINDOW_SEC 600
+#define ACCEL_BATCH_SIZE 25
+#define ACCEL_STILL_ENERGY_MG 40
+#define ACCEL_MOVE_ENERGY_MG 150
+#define ACCEL_SETTLED_BATCHES 12
+#define ACCEL_STAND_CONFIRM_BATCHES 4
+#define ACCEL_ARM_HANGING_Y_MG -700
+#define BASELINE_HISTORY_SEC SECONDS_PER_DAY
+#define BASELINE_CHUNK_MINUTES 30
+#define BASELINE_CHUNK_DELAY_MS 50
+#define BASELINE_START_DELAY_MS 5000
+#define BASELINE_REST_MAX_VMC 100
+#define BASELINE_MIN_REST_MINUTES 30
+#define HR_ZONE_PERSIST_INTERVAL_SEC 300
+#define SPARK_MINUTES 60
+#define SPARK_HEIGHT 20
+#define SPARK_MIN_BPM 40
+#define SPARK_MAX_BPM 180
+#define HR_LOG_PAGE_COUNT 4
+#define HR_LOG_EVENTS_PER_PAGE 15
+#define HR_LOG_FLUSH_DELAY_MS (5 * 60 * 1000)
+#define HR_LOG_EVENTS_PER_MESSAGE 8
+#define HR_LOG_MAX_SEND_FAILURES 3
+#define ALERT_COOLDOWN_SEC 300
+// A flick this soon after an alert vibe still snoozes, even if the alert
+// has already cleared
+#define ALERT_SNOOZE_WINDOW_SEC 60
+#define ALERT_MAX_VIBES_PER_HOUR 4
+#define SNOOZE_DEFAULT_MINUTES 30
+#define BT_ALERT_DELAY_DEFAULT_SEC 15
+#define LOCATION_MIN_MOVE_E2 10
+#define STEPS_QUERY_INTERVAL_SEC 60
+#define WEATHER_ICON_GAP 3
+#define WEATHER_INTERVAL_SEC (30 * 60)
+// Cached weather older than this is not shown at launch
+#define WEATHER_DISPLAY_MAX_AGE_SEC (3 * 60 * 60)
+// Bumped whenever the launch handshake changes; PebbleKit JS falls back to a
+// full refresh on a mismatch
+#define PROTOCOL_VERSION 1
+// The date font resource sized for this display (generated per platform in
+// package.json from DATE_FONT_SIZE)
+#define PRV_JERSEY_FONT_ID(size) RESOURCE_ID_FONT_JERSEY_ ## size
+#define PRV_JERSEY_FONT_ID_EXPAND(size) PRV_JERSEY_FONT_ID(size)
+#define DATE_FONT_RESOURCE_ID PRV_JERSEY_FONT_ID_EXPAND(DATE_FONT_SIZE)
+#define DATE_LINE_HEIGHT (DATE_FONT_SIZE + 6)
 
 // Define our settings struct
 typedef struct ClaySettings {
@@ -13,25 +77,126 @@ typedef struct ClaySettings {
   GColor TextColor;
   bool TemperatureUnit; // false = Celsius, true = Fahrenheit
   bool ShowDate;
+  bool SlopeAlert;
+  int SnoozeMinutes;
+  uint8_t TopSlot;
+  uint8_t LowerSlot;
+  uint8_t BottomSlot;
+  char Language[3];
+  int BtAlertDelay;
+  // Opaque hash of the phone's stored settings, echoed in the handshake
+  uint32_t SettingsHash;
 } ClaySettings;
 
+// Resting HR baseline, persisted with the day it was computed for so it is
+// only rebuilt once per day.
+typedef struct RestingBaseline {
+  time_t day_start;
+  HealthValue bpm;
+} RestingBaseline;
+
+// Seconds spent in each HR zone today, persisted with the day they belong to.
+typedef struct HrZoneTotals {
+  time_t day_start;
+  HrZoneClock clock;
+} HrZoneTotals;
+
+// One finished HR alert. The layout is fixed at 16 bytes so pages can be sent
+// to PebbleKit JS as raw bytes; seq 0 marks an unused slot.
+typedef struct HrLogEvent {
+  uint32_t seq;
+  uint32_t start;
+  uint16_t duration_sec;
+  uint8_t min;
+  uint8_t max;
+  uint8_t delta;
+  uint8_t flags;
+  uint8_t reserved[2];
+} HrLogEvent;
+
+#define HR_LOG_FLAG_STAND 0x01
+
+// Last coordinates from PebbleKit JS in hundredths of a degree, cached so sun
+// times can be computed offline.
+typedef struct SunLocation {
+  int32_t lat_e2;
+  int32_t lon_e2;
+  bool valid;
+} SunLocation;
+
+// Last weather report, persisted so a relaunch can show it and tell the phone
+// how old it is
+typedef struct CachedWeather {
+  time_t time;
+  int16_t temp_c;
+  int16_t code;
+} CachedWeather;
+
+#if FEATURE_SECOND_ZONE
+// Second time zone as resolved by PebbleKit JS: the current UTC offset and the
+// next DST change, so the watch can switch offsets without a round trip.
+typedef struct SecondZone {
+  int32_t offset_min;
+  int32_t next_offset_min;
+  time_t next_change;
+  char label[16];
+  bool valid;
+} SecondZone;
+#endif
+
+// A journal page fits in a single persist key (256 bytes max).
+typedef struct HrLogPage {
+  HrLogEvent events[HR_LOG_EVENTS_PER_PAGE];
+} HrLogPage;
+
 // An instance of the struct
 static ClaySettings settings;
 
 static Window *s_main_window;
-static TextLayer *s_time_layer;
+// The time is drawn from the pre-rasterised digit atlas, not a TextLayer
+static Layer *s_time_layer;
+static char s_time_text[TIME_FORMAT_CLOCK_SIZE];
+static int s_time_width;
 static TextLayer *s_date_layer;
-static TextLayer *s_hr_layer;
-static TextLayer *s_weather_layer;
+static TextLayer *s_slot_layers[SlotCount];
+static TextFit s_slot_fits[SlotCount];
 
 // Custom fonts
-static GFont s_time_font;
 static GFont s_date_font;
 
 // Battery
 static Layer *s_battery_layer;
 static int s_battery_level;
 
+// Weather as last received, rendered by the weather complication in the
+// current unit and language
+static bool s_weather_valid;
+static time_t s_weather_time;
+static time_t s_weather_last_request;
+static int s_weather_temp_c;
+static int s_weather_code;
+
+#if FEATURE_WEATHER_ICONS
+// Weather condition icon. Only the icon for the current condition is loaded,
+// and only while the weather complication sits in a lower slot.
+static Layer *s_weather_icon_layer;
+static GDrawCommandImage *s_weather_icon;
+static uint32_t s_weather_icon_id;
+#endif
+
+// Day of year the date line was last formatted for
+static int s_date_layer_yday = -1;
+
+// Sunrise/sunset
+static SunLocation s_sun_location;
+static int s_sun_yday = -1;
+static int s_date_yday = -1;
+
+#if FEATURE_SECOND_ZONE
+// Second time zone
+static SecondZone s_second_zone;
+#endif
+
 // Bluetooth
 static BitmapLayer *s_bt_icon_layer;
 static GBitmap *s_bt_icon_bitmap;
@@ -41,247 +206,1566 @@ static Layer *s_window_layer;
 static AppTimer *s_hr_alert_timer;
 static bool s_hr_alert_active;
 #if defined(PBL_HEALTH)
-static HealthValue s_hr_sample_values[HR_SAMPLE_BUFFER_SIZE];
-static time_t s_hr_sample_times[HR_SAMPLE_BUFFER_SIZE];
-static int s_hr_sample_count;
+static HrOutlierFilter s_hr_filter;
+static HrWindow s_hr_window;
+static HrBlockWindows s_hr_blocks;
+
+// Stand-up detection. Accel batches are only consumed while no stand window is
+// open; during a window HR is sampled fast and compared against the baseline
+// captured just before the stand.
+static bool s_accel_subscribed;
+static int s_still_batches;
+static bool s_settled;
+static bool s_settled_arm_hanging;
+static int s_stand_confirm_batches;
+static bool s_stand_active;
+static AppTimer *s_stand_timer;
+static HealthValue s_stand_baseline_hr;
+static int32_t s_stand_peak_delta;
+
+// Daily resting baseline and the chunked minute-history scan that builds it.
+static RestingBaseline s_baseline;
+static AppTimer *s_baseline_timer;
+static HealthMinuteData *s_baseline_minutes;
+static time_t s_baseline_scan_start;
+static time_t s_baseline_scan_end;
+static uint32_t s_baseline_scan_sum;
+static uint32_t s_baseline_scan_count;
+
+#if defined(PBL_BW)
+// Topmost layer that inverts the finished frame while an alert is active,
+// since black-and-white screens have no alert colour to switch to
+static Layer *s_alert_invert_layer;
+#endif
+
+// Time-in-zone accounting for today.
+static Layer *s_zone_layer;
+static HrZoneTotals s_zone_totals;
+static time_t s_zone_last_persist;
+static int s_zone_drawn_widths[HrZoneCount];
+
+// Sparkline of per-minute min/max HR. Column i of the bitmap always holds ring
+// slot i, so a new minute renders one column and moves the head; the two
+// sub-bitmaps split the ring at the head so the oldest minute draws leftmost.
+static Layer *s_spark_layer;
+static GBitmap *s_spark_bitmap;
+static GBitmap *s_spark_old_part;
+static GBitmap *s_spark_new_part;
+static uint8_t s_spark_min[SPARK_MINUTES];
+static uint8_t s_spark_max[SPARK_MINUTES];
+static int s_spark_head;
+
+// HR event journal. Event seq n lives in page (n / per-page) % pages, so
+// successive writes rotate across keys. Only the page being filled is held in
+// RAM and it is flushed when full, on a timer, or at exit.
+static HrLogPage s_hr_log_page;
+static HrLogPage s_hr_log_read_page;
+static uint32_t s_hr_log_read_key;
+static uint32_t s_hr_log_next_seq;
+static bool s_hr_log_dirty;
+static AppTimer *s_hr_log_flush_timer;
+static uint32_t s_hr_log_export_seq;
+static bool s_hr_log_exporting;
+// The chunk in the outbox, if any: its first seq and whether it is the empty
+// end marker
+static bool s_hr_log_chunk_in_flight;
+static bool s_hr_log_chunk_final;
+static uint32_t s_hr_log_chunk_seq;
+static int s_hr_log_send_failures;
+
+// The alert currently being recorded
+static bool s_alert_event_open;
+static time_t s_alert_event_start;
+static uint8_t s_alert_event_min;
+static uint8_t s_alert_event_max;
+static uint8_t s_alert_event_delta;
+static uint8_t s_alert_event_flags;
+
+// Alert suppression: snooze (wrist flick) and post-event cooldown share one
+// deadline; recent vibration times form a ring for the hourly cap.
+static time_t s_alert_suppressed_until;
+static time_t s_alert_vibe_times[ALERT_MAX_VIBES_PER_HOUR];
+static int s_alert_vibe_head;
+
+// Steps and active minutes. Movement events arrive many times a minute while
+// walking, so they only raise a flag and the totals are read at most once a
+// minute.
+static HealthValue s_steps_today;
+static HealthValue s_active_minutes_today;
+static bool s_steps_pending;
+static time_t s_steps_last_query;
 #endif
 static HealthValue s_last_filtered_hr;
 static HealthValue s_last_raw_hr;
 static uint32_t s_last_window_delta;
+static int32_t s_last_window_slope;
+static uint32_t s_last_short_window_delta;
+static uint32_t s_last_long_window_delta;
+static HealthValue s_last_window_mean;
 
 static void prv_update_display();
+static void prv_update_fit_widths(void);
+#if FEATURE_WEATHER_ICONS
+static void prv_tint_weather_icon(void);
+#endif
 #if defined(PBL_HEALTH)
 static void hr_alert_timer_callback(void *context);
 #endif
 
-static void prv_update_hr_display() {
-  static char s_hr_buffer[24];
+static void prv_render_hr(char *buffer, size_t size) {
+
+#if defined(PBL_HEALTH)
+  if (s_last_filtered_hr > 0 && s_stand_active) {
+    int32_t stand_delta = s_last_filtered_hr - s_stand_baseline_hr;
+    snprintf(buffer, size, "%lu BPM Stand %c%ld",
+             (uint32_t)s_last_filtered_hr,
+             stand_delta < 0 ? '-' : '+',
+             (long)(stand_delta < 0 ? -stand_delta : stand_delta));
+    return;
+  }
+#endif
+
+#if defined(PBL_HEALTH)
+  if (s_last_filtered_hr > 0 && s_baseline.bpm > 0) {
+    int32_t slope = s_last_window_slope;
+    int32_t pct = hr_percent_above_baseline(s_last_filtered_hr, s_baseline.bpm);
+    snprintf(buffer, size, "%lu %c%ld%% Δ%lu %c%ld/m",
+             (uint32_t)s_last_filtered_hr,
+             pct < 0 ? '-' : '+',
+             (long)(pct < 0 ? -pct : pct),
+             (uint32_t)s_last_window_delta,
+             slope < 0 ? '-' : '+',
+             (long)(slope < 0 ? -slope : slope));
+    return;
+  }
+#endif
 
   if (s_last_filtered_hr > 0) {
-    snprintf(s_hr_buffer, sizeof(s_hr_buffer), "%lu BPM | Δ%lu",
+    int32_t slope = s_last_window_slope;
+    snprintf(buffer, size, "%lu BPM Δ%lu %c%ld/m",
              (uint32_t)s_last_filtered_hr,
-             (uint32_t)s_last_window_delta);
+             (uint32_t)s_last_window_delta,
+             slope < 0 ? '-' : '+',
+             (long)(slope < 0 ? -slope : slope));
   } else {
-    snprintf(s_hr_buffer, sizeof(s_hr_buffer), "-- BPM");
+    snprintf(buffer, size, "-- BPM");
   }
-
-  text_layer_set_text(s_hr_layer, s_hr_buffer);
 }
 
 #if defined(PBL_HEALTH)
+static uint32_t prv_hr_log_page_key(uint32_t seq) {
+  return HR_LOG_FIRST_KEY + ((seq / HR_LOG_EVENTS_PER_PAGE) % HR_LOG_PAGE_COUNT);
+}
+
+static void prv_hr_log_flush(void) {
+  if (s_hr_log_flush_timer) {
+    app_timer_cancel(s_hr_log_flush_timer);
+    s_hr_log_flush_timer = NULL;
+  }
+  if (!s_hr_log_dirty) {
+    return;
+  }
+
+  // The page in RAM is the one the last written event belongs to
+  persist_write_data(prv_hr_log_page_key(s_hr_log_next_seq - 1), &s_hr_log_page,
+                     sizeof(s_hr_log_page));
+  s_hr_log_dirty = false;
+  s_hr_log_read_key = 0;
+}
+
+static void hr_log_flush_timer_callback(void *context) {
+  s_hr_log_flush_timer = NULL;
+  prv_hr_log_flush();
+}
+
+/**
+ * Finds the next sequence number by scanning the pages once, then keeps the
+ * page holding the newest event resident.
+ */
+static void prv_hr_log_load(void) {
+  uint32_t last_seq = 0;
+  for (uint32_t page = 0; page < HR_LOG_PAGE_COUNT; page++) {
+    s_hr_log_page = (HrLogPage) { 0 };
+    persist_read_data(HR_LOG_FIRST_KEY + page, &s_hr_log_page, sizeof(s_hr_log_page));
+    for (int index = 0; index < HR_LOG_EVENTS_PER_PAGE; index++) {
+      if (s_hr_log_page.events[index].seq > last_seq) {
+        last_seq = s_hr_log_page.events[index].seq;
+      }
+    }
+  }
+
+  s_hr_log_next_seq = last_seq + 1;
+  s_hr_log_page = (HrLogPage) { 0 };
+  if (last_seq > 0) {
+    persist_read_data(prv_hr_log_page_key(last_seq), &s_hr_log_page, sizeof(s_hr_log_page));
+  }
+}
+
+/**
+ * Appends an event to the resident page. Crossing into a new page flushes the
+ * finished one first; otherwise the write is deferred so bursts of alerts cost
+ * a single flash write.
+ */
+static void prv_hr_log_append(HrLogEvent event) {
+  uint32_t seq = s_hr_log_next_seq;
+  uint32_t slot = seq % HR_LOG_EVENTS_PER_PAGE;
+
+  if (slot == 0) {
+    prv_hr_log_flush();
+    // The previous occupant of this page is being overwritten wholesale
+    s_hr_log_page = (HrLogPage) { 0 };
+  }
+
+  s_hr_log_next_seq++;
+  event.seq = seq;
+  s_hr_log_page.events[slot] = event;
+  s_hr_log_dirty = true;
+
+  if (slot == HR_LOG_EVENTS_PER_PAGE - 1) {
+    prv_hr_log_flush();
+  } else if (!s_hr_log_flush_timer) {
+    s_hr_log_flush_timer = app_timer_register(power_interval(HR_LOG_FLUSH_DELAY_MS),
+                                              hr_log_flush_timer_callback, NULL);
+  }
+}
+
+/**
+ * Reads the event with the given sequence number, from RAM when it is on the
+ * resident page. Returns false when it has been overwritten or never existed.
+ */
+static bool prv_hr_log_read(uint32_t seq, HrLogEvent *out) {
+  if (seq == 0 || seq >= s_hr_log_next_seq) {
+    return false;
+  }
+
+  const HrLogPage *page = &s_hr_log_page;
+  uint32_t key = prv_hr_log_page_key(seq);
+  if (key != prv_hr_log_page_key(s_hr_log_next_seq - 1)) {
+    if (key != s_hr_log_read_key) {
+      s_hr_log_read_page = (HrLogPage) { 0 };
+      persist_read_data(key, &s_hr_log_read_page, sizeof(s_hr_log_read_page));
+      s_hr_log_read_key = key;
+    }
+    page = &s_hr_log_read_page;
+  }
+
+  const HrLogEvent *event = &page->events[seq % HR_LOG_EVENTS_PER_PAGE];
+  if (event->seq != seq) {
+    return false;
+  }
+  *out = *event;
+  return true;
+}
+
+/**
+ * Sends the next batch of logged events to PebbleKit JS. Called again from the
+ * outbox handlers until everything from the requested seq has gone out; an
+ * empty HR_LOG_CHUNK marks the end. While another message holds the outbox
+ * the export just waits for that message's callback.
+ */
+static void prv_hr_log_send_next(void) {
+  if (!s_hr_log_exporting || s_hr_log_chunk_in_flight) {
+    return;
+  }
+
+  // Skip anything already overwritten by newer pages
+  uint32_t capacity = HR_LOG_PAGE_COUNT * HR_LOG_EVENTS_PER_PAGE;
+  if (s_hr_log_next_seq > capacity && s_hr_log_export_seq < s_hr_log_next_seq - capacity) {
+    s_hr_log_export_seq = s_hr_log_next_seq - capacity;
+  }
+
+  HrLogEvent batch[HR_LOG_EVENTS_PER_MESSAGE];
+  int count = 0;
+  uint32_t seq = s_hr_log_export_seq;
+  while (count < HR_LOG_EVENTS_PER_MESSAGE && seq < s_hr_log_next_seq) {
+    if (prv_hr_log_read(seq, &batch[count])) {
+      count++;
+    }
+    seq++;
+  }
+
+  DictionaryIterator *iter;
+  if (app_message_outbox_begin(&iter) != APP_MSG_OK) {
+    return;
+  }
+  dict_write_data(iter, MESSAGE_KEY_HR_LOG_CHUNK, (const uint8_t *)batch,
+                  count * sizeof(HrLogEvent));
+  if (app_message_outbox_send() != APP_MSG_OK) {
+    return;
+  }
+
+  s_hr_log_chunk_in_flight = true;
+  s_hr_log_chunk_final = count == 0;
+  s_hr_log_chunk_seq = s_hr_log_export_seq;
+  s_hr_log_export_seq = seq;
+}
+
+// Outbox sent: the export moves on, or ends once the end marker is delivered
+static void prv_hr_log_outbox_sent(void) {
+  if (s_hr_log_chunk_in_flight) {
+    s_hr_log_chunk_in_flight = false;
+    s_hr_log_send_failures = 0;
+    if (s_hr_log_chunk_final) {
+      s_hr_log_exporting = false;
+    }
+  }
+  prv_hr_log_send_next();
+}
+
+// Outbox failed: resend our chunk, giving up after a few failures in a row
+static void prv_hr_log_outbox_failed(void) {
+  if (s_hr_log_chunk_in_flight) {
+    s_hr_log_chunk_in_flight = false;
+    s_hr_log_export_seq = s_hr_log_chunk_seq;
+    if (++s_hr_log_send_failures >= HR_LOG_MAX_SEND_FAILURES) {
+      s_hr_log_exporting = false;
+      s_hr_log_send_failures = 0;
+      return;
+    }
+  }
+  prv_hr_log_send_next();
+}
+
+static void prv_hr_log_start_export(uint32_t from_seq) {
+  // A seq from the future means the journal was reset; resend everything
+  s_hr_log_export_seq = (from_seq > 0 && from_seq <= s_hr_log_next_seq) ? from_seq : 1;
+  s_hr_log_exporting = true;
+  s_hr_log_chunk_final = false;
+  s_hr_log_send_failures = 0;
+  prv_hr_log_send_next();
+}
+
+/**
+ * Opens or extends the event for the alert being raised.
+ */
+static void prv_track_alert_event(HealthValue raw_hr, uint32_t delta_bpm) {
+  uint8_t value = raw_hr > UINT8_MAX ? UINT8_MAX : (uint8_t)raw_hr;
+  uint8_t delta = delta_bpm > UINT8_MAX ? UINT8_MAX : (uint8_t)delta_bpm;
+
+  if (!s_alert_event_open) {
+    s_alert_event_open = true;
+    s_alert_event_start = time(NULL);
+    s_alert_event_min = value;
+    s_alert_event_max = value;
+    s_alert_event_delta = delta;
+    s_alert_event_flags = s_stand_active ? HR_LOG_FLAG_STAND : 0;
+    return;
+  }
+
+  if (value < s_alert_event_min) {
+    s_alert_event_min = value;
+  }
+  if (value > s_alert_event_max) {
+    s_alert_event_max = value;
+  }
+  if (delta > s_alert_event_delta) {
+    s_alert_event_delta = delta;
+  }
+}
+
+static void prv_close_alert_event(void) {
+  if (!s_alert_event_open) {
+    return;
+  }
+  s_alert_event_open = false;
+
+  time_t duration = time(NULL) - s_alert_event_start;
+  prv_hr_log_append((HrLogEvent) {
+    .start = (uint32_t)s_alert_event_start,
+    .duration_sec = duration > UINT16_MAX ? UINT16_MAX : (uint16_t)duration,
+    .min = s_alert_event_min,
+    .max = s_alert_event_max,
+    .delta = s_alert_event_delta,
+    .flags = s_alert_event_flags,
+  });
+}
+
+/**
+ * Raises or clears the alert. The window is only repainted when the state
+ * actually changes; a repeat trigger just pushes the expiry timer back.
+ */
 static void prv_set_hr_alert_active(bool active) {
   if (s_hr_alert_timer) {
     app_timer_cancel(s_hr_alert_timer);
     s_hr_alert_timer = NULL;
   }
 
-  s_hr_alert_active = active;
-  prv_update_display();
+  if (s_hr_alert_active != active) {
+    s_hr_alert_active = active;
+    prv_update_display();
+  }
+
+  if (active) {
+    s_hr_alert_timer = app_timer_register(HR_ALERT_WINDOW_SEC * 1000, hr_alert_timer_callback, NULL);
+  }
+}
+
+static void prv_suppress_alerts_until(time_t until) {
+  if (until > s_alert_suppressed_until) {
+    s_alert_suppressed_until = until;
+  }
+}
+
+#if defined(PBL_BW)
+/**
+ * Inverts everything drawn beneath this layer in place. The black-and-white
+ * health watches have rectangular 1-bit frame buffers, so every bit is
+ * flipped a word at a time.
+ */
+static void alert_invert_update_proc(Layer *layer, GContext *ctx) {
+  GBitmap *frame = graphics_capture_frame_buffer(ctx);
+  if (!frame) {
+    return;
+  }
+
+  uint8_t *data = gbitmap_get_data(frame);
+  size_t size = (size_t)gbitmap_get_bytes_per_row(frame) * gbitmap_get_bounds(frame).size.h;
+  uint32_t *words = (uint32_t *)data;
+  size_t word_count = size / sizeof(uint32_t);
+  for (size_t index = 0; index < word_count; index++) {
+    words[index] ^= 0xFFFFFFFFu;
+  }
+  for (size_t index = word_count * sizeof(uint32_t); index < size; index++) {
+    data[index] ^= 0xFF;
+  }
+
+  graphics_release_frame_buffer(ctx, frame);
+}
+#endif
+
+static void hr_alert_timer_callback(void *context) {
+  s_hr_alert_timer = NULL;
+  s_hr_alert_active = false;
+  prv_close_alert_event();
+  prv_suppress_alerts_until(time(NULL) + ALERT_COOLDOWN_SEC);
+  prv_update_display();
+}
+
+/**
+ * Returns true and records the vibration when fewer than the hourly cap have
+ * fired in the last hour. The ring holds exactly the cap, so checking the
+ * oldest entry is enough.
+ */
+static bool prv_take_alert_vibe(time_t now) {
+  time_t oldest = s_alert_vibe_times[s_alert_vibe_head];
+  if (oldest != 0 && (now - oldest) < SECONDS_PER_HOUR) {
+    return false;
+  }
+
+  s_alert_vibe_times[s_alert_vibe_head] = now;
+  s_alert_vibe_head = (s_alert_vibe_head + 1) % ALERT_MAX_VIBES_PER_HOUR;
+  return true;
+}
+
+/**
+ * A wrist flick dismisses a showing alert and snoozes HR alerts for the
+ * configured period. Flicks and taps also come from ordinary arm movement, so
+ * they are ignored unless an alert is showing or has just vibrated.
+ */
+static void accel_tap_handler(AccelAxisType axis, int32_t direction) {
+  time_t now = time(NULL);
+  time_t last_vibe =
+      s_alert_vibe_times[(s_alert_vibe_head + ALERT_MAX_VIBES_PER_HOUR - 1) % ALERT_MAX_VIBES_PER_HOUR];
+  if (!s_hr_alert_active && (last_vibe == 0 || now - last_vibe > ALERT_SNOOZE_WINDOW_SEC)) {
+    return;
+  }
+
+  prv_suppress_alerts_until(now + (settings.SnoozeMinutes * SECONDS_PER_MINUTE));
+  APP_LOG(APP_LOG_LEVEL_INFO, "HR alerts snoozed for %d min", settings.SnoozeMinutes);
+
+  if (s_hr_alert_active) {
+    prv_close_alert_event();
+    prv_set_hr_alert_active(false);
+  }
+}
+#endif
+
+#if defined(PBL_HEALTH)
+/**
+ * Returns the current heart-rate value for the given metric when available,
+ * otherwise 0. This centralizes accessibility checks for both filtered and
+ * raw BPM queries.
+ */
+static HealthValue prv_get_heart_rate_metric(HealthMetric metric) {
+  HealthServiceAccessibilityMask accessible =
+      health_service_metric_accessible(metric, time(NULL), time(NULL));
+  if (!(accessible & HealthServiceAccessibilityMaskAvailable)) {
+    return 0;
+  }
+
+  HealthValue value = health_service_peek_current_value(metric);
+  return value > 0 ? value : 0;
+}
+
+/**
+ * Applies alert rules for the latest computed window delta and, when enabled,
+ * the rising slope. If a threshold is met, background alert is activated and
+ * vibration is emitted once per event. New events are held back while snoozed
+ * or cooling down, and vibration is capped per hour.
+ */
+static void prv_evaluate_hr_alert(uint32_t delta_bpm, int32_t slope_bpm_per_min) {
+  bool slope_triggered = settings.SlopeAlert && slope_bpm_per_min >= HR_ALERT_SLOPE_BPM_PER_MIN;
+  if (delta_bpm < HR_ALERT_DELTA_BPM && !slope_triggered) {
+    return;
+  }
+
+  if (!s_hr_alert_active) {
+    time_t now = time(NULL);
+    if (now < s_alert_suppressed_until) {
+      return;
+    }
+    if (prv_take_alert_vibe(now)) {
+      vibes_short_pulse();
+    }
+  }
+  prv_set_hr_alert_active(true);
+}
+
+/**
+ * Computes each zone's pixel share of a bar of the given width.
+ */
+static void prv_zone_widths(int width, int widths[HrZoneCount]) {
+  uint32_t total = 0;
+  for (int zone = 0; zone < HrZoneCount; zone++) {
+    total += s_zone_totals.clock.seconds[zone];
+  }
+
+  for (int zone = 0; zone < HrZoneCount; zone++) {
+    widths[zone] = total > 0 ? (int)(((uint64_t)s_zone_totals.clock.seconds[zone] * width) / total) : 0;
+  }
+}
+
+static void zone_update_proc(Layer *layer, GContext *ctx) {
+  GRect bounds = layer_get_bounds(layer);
+  prv_zone_widths(bounds.size.w, s_zone_drawn_widths);
+
+  const GColor colors[HrZoneCount] = {
+    PBL_IF_COLOR_ELSE(GColorGreen, settings.BackgroundColor),
+    PBL_IF_COLOR_ELSE(GColorChromeYellow, settings.TextColor),
+    PBL_IF_COLOR_ELSE(GColorRed, settings.TextColor),
+  };
+
+  int x = 0;
+  for (int zone = 0; zone < HrZoneCount; zone++) {
+    if (s_zone_drawn_widths[zone] > 0) {
+      graphics_context_set_fill_color(ctx, colors[zone]);
+      graphics_fill_rect(ctx, GRect(x, 0, s_zone_drawn_widths[zone], bounds.size.h), 0, GCornerNone);
+      x += s_zone_drawn_widths[zone];
+    }
+  }
+
+  // Outline so rest time (background coloured on B&W) still reads as a bar
+  graphics_context_set_stroke_color(ctx, settings.TextColor);
+  graphics_draw_rect(ctx, bounds);
+}
+
+static void prv_reset_zone_totals(void) {
+  s_zone_totals = (HrZoneTotals) { .day_start = time_start_of_today() };
+  persist_write_data(ZONES_KEY, &s_zone_totals, sizeof(s_zone_totals));
+  if (s_zone_layer) {
+    layer_mark_dirty(s_zone_layer);
+  }
+}
+
+static void prv_load_zone_totals(void) {
+  s_zone_totals = (HrZoneTotals) { 0 };
+  persist_read_data(ZONES_KEY, &s_zone_totals, sizeof(s_zone_totals));
+  if (s_zone_totals.day_start != time_start_of_today()) {
+    prv_reset_zone_totals();
+  }
+  // The previous run's last sample is too old to charge to a zone
+  s_zone_totals.clock.last_time = 0;
+  s_zone_last_persist = time(NULL);
+}
+
+/**
+ * Charges the time since the previous sample to its zone. Totals are persisted
+ * at most every few minutes and the bar is only redrawn when a segment width
+ * actually changes.
+ */
+static void prv_account_hr_zone(HealthValue bpm, time_t now) {
+  hr_zone_clock_add(&s_zone_totals.clock, (uint32_t)now, bpm, s_baseline.bpm);
+
+  if (now - s_zone_last_persist >= (time_t)power_interval(HR_ZONE_PERSIST_INTERVAL_SEC)) {
+    persist_write_data(ZONES_KEY, &s_zone_totals, sizeof(s_zone_totals));
+    s_zone_last_persist = now;
+  }
+
+  int widths[HrZoneCount];
+  prv_zone_widths(layer_get_bounds(s_zone_layer).size.w, widths);
+  if (memcmp(widths, s_zone_drawn_widths, sizeof(widths)) != 0) {
+    layer_mark_dirty(s_zone_layer);
+  }
+}
+
+/**
+ * Maps a BPM value to a sparkline row, 0 being the top.
+ */
+static int prv_spark_row(uint8_t bpm) {
+  int clamped = bpm < SPARK_MIN_BPM ? SPARK_MIN_BPM : (bpm > SPARK_MAX_BPM ? SPARK_MAX_BPM : bpm);
+  return (SPARK_HEIGHT - 1) -
+         ((clamped - SPARK_MIN_BPM) * (SPARK_HEIGHT - 1)) / (SPARK_MAX_BPM - SPARK_MIN_BPM);
+}
+
+/**
+ * Writes a single sparkline column straight into the bitmap. Colour builds
+ * use a one-third-alpha text colour so the HR text on top stays legible; 1-bit
+ * builds dither the ink instead.
+ */
+static void prv_render_spark_column(int column) {
+  uint8_t *data = gbitmap_get_data(s_spark_bitmap);
+  uint16_t stride = gbitmap_get_bytes_per_row(s_spark_bitmap);
+  bool has_data = s_spark_max[column] > 0;
+  int top = has_data ? prv_spark_row(s_spark_max[column]) : SPARK_HEIGHT;
+  int bottom = has_data ? prv_spark_row(s_spark_min[column]) : -1;
+
+#if defined(PBL_COLOR)
+  GColor ink = settings.TextColor;
+  ink.a = 1;
+  for (int row = 0; row < SPARK_HEIGHT; row++) {
+    data[(row * stride) + column] = (row >= top && row <= bottom) ? ink.argb : GColorClear.argb;
+  }
+#else
+  bool ink_white = gcolor_equal(settings.TextColor, GColorWhite);
+  uint8_t mask = 1 << (column % 8);
+  for (int row = 0; row < SPARK_HEIGHT; row++) {
+    bool ink = row >= top && row <= bottom && ((row + column) & 1) == 0;
+    uint8_t *byte = &data[(row * stride) + (column / 8)];
+    if (ink == ink_white) {
+      *byte |= mask;
+    } else {
+      *byte &= ~mask;
+    }
+  }
+#endif
+}
+
+/**
+ * Re-splits the ring at the head into the two sub-bitmaps used for drawing.
+ */
+static void prv_split_spark_bitmap(void) {
+  if (s_spark_old_part) {
+    gbitmap_destroy(s_spark_old_part);
+    s_spark_old_part = NULL;
+  }
+  if (s_spark_new_part) {
+    gbitmap_destroy(s_spark_new_part);
+    s_spark_new_part = NULL;
+  }
+
+  if (s_spark_head < SPARK_MINUTES) {
+    s_spark_old_part = gbitmap_create_as_sub_bitmap(
+        s_spark_bitmap, GRect(s_spark_head, 0, SPARK_MINUTES - s_spark_head, SPARK_HEIGHT));
+  }
+  if (s_spark_head > 0) {
+    s_spark_new_part = gbitmap_create_as_sub_bitmap(
+        s_spark_bitmap, GRect(0, 0, s_spark_head, SPARK_HEIGHT));
+  }
+}
+
+/**
+ * Renders every column. Only needed when the bitmap is created, the ink
+ * colour changes or the layer is shown again after missing minutes.
+ */
+static void prv_rebuild_sparkline(void) {
+  if (!s_spark_bitmap || layer_get_hidden(s_spark_layer)) {
+    return;
+  }
+  for (int column = 0; column < SPARK_MINUTES; column++) {
+    prv_render_spark_column(column);
+  }
+  prv_split_spark_bitmap();
+  layer_mark_dirty(s_spark_layer);
+}
+
+/**
+ * Appends a finished minute, plus empty columns for any minutes without
+ * samples before the next one. Only the new columns are rendered.
+ */
+static void prv_push_spark_minute(const HrBlock *minute, uint32_t skipped_minutes) {
+  // Keep the history while hidden; it is rebuilt when the HR slot is placed
+  bool render = s_spark_bitmap && !layer_get_hidden(s_spark_layer);
+  uint32_t columns = 1 + (skipped_minutes < SPARK_MINUTES ? skipped_minutes : SPARK_MINUTES);
+
+  for (uint32_t index = 0; index < columns; index++) {
+    bool is_minute = index == 0 && minute->count > 0;
+    s_spark_min[s_spark_head] = is_minute ? minute->min : 0;
+    s_spark_max[s_spark_head] = is_minute ? minute->max : 0;
+    if (render) {
+      prv_render_spark_column(s_spark_head);
+    }
+    s_spark_head = (s_spark_head + 1) % SPARK_MINUTES;
+  }
+
+  if (render) {
+    prv_split_spark_bitmap();
+    layer_mark_dirty(s_spark_layer);
+  }
+}
+
+static void spark_update_proc(Layer *layer, GContext *ctx) {
+  graphics_context_set_compositing_mode(ctx, PBL_IF_COLOR_ELSE(GCompOpSet, GCompOpAssign));
+  int old_width = SPARK_MINUTES - s_spark_head;
+  if (s_spark_old_part) {
+    graphics_draw_bitmap_in_rect(ctx, s_spark_old_part, GRect(0, 0, old_width, SPARK_HEIGHT));
+  }
+  if (s_spark_new_part) {
+    graphics_draw_bitmap_in_rect(ctx, s_spark_new_part,
+                                 GRect(old_width, 0, s_spark_head, SPARK_HEIGHT));
+  }
+}
+
+static void prv_accel_data_handler(AccelData *data, uint32_t num_samples);
+
+/**
+ * Subscribes to batched low-rate accel data for posture tracking.
+ */
+static void prv_posture_subscribe(void) {
+  if (s_accel_subscribed) {
+    return;
+  }
+
+  s_still_batches = 0;
+  s_settled = false;
+  s_stand_confirm_batches = 0;
+  accel_data_service_subscribe(ACCEL_BATCH_SIZE, prv_accel_data_handler);
+  accel_service_set_sampling_rate(ACCEL_SAMPLING_10HZ);
+  s_accel_subscribed = true;
+}
+
+static void prv_posture_unsubscribe(void) {
+  if (!s_accel_subscribed) {
+    return;
+  }
+
+  accel_data_service_unsubscribe();
+  s_accel_subscribed = false;
+}
+
+/**
+ * Closes the focused stand window: logs the peak rise over baseline, returns
+ * HR sampling to the idle period and resumes posture tracking.
+ */
+static void stand_timer_callback(void *context) {
+  s_stand_timer = NULL;
+  s_stand_active = false;
+
+  APP_LOG(APP_LOG_LEVEL_INFO, "Stand window closed baseline=%ld peak=+%ld",
+          (long)s_stand_baseline_hr, (long)s_stand_peak_delta);
+
+  health_service_set_heart_rate_sample_period(HR_IDLE_SAMPLE_PERIOD_SEC);
+  prv_posture_subscribe();
+  complications_mark_dirty(ComplicationHeartRate);
+}
+
+/**
+ * Opens a focused measurement window after a stand-up. The baseline is the
+ * mean of the 5-minute block window, which still reflects the rest period.
+ */
+static void prv_start_stand_window(void) {
+  HrBlock rest = hr_blocks_query(&s_hr_blocks, HR_LONG_WINDOW_SEC);
+  s_stand_baseline_hr = rest.count > 0 ? hr_block_mean(&rest) : s_last_filtered_hr;
+  if (s_stand_baseline_hr <= 0) {
+    return;
+  }
+
+  s_stand_active = true;
+  s_stand_peak_delta = 0;
+  APP_LOG(APP_LOG_LEVEL_INFO, "Stand detected baseline=%ld", (long)s_stand_baseline_hr);
+
+  prv_posture_unsubscribe();
+  health_service_set_heart_rate_sample_period(HR_FAST_SAMPLE_PERIOD_SEC);
+  s_stand_timer = app_timer_register(STAND_WINDOW_SEC * 1000, stand_timer_callback, NULL);
+  complications_mark_dirty(ComplicationHeartRate);
+}
+
+/**
+ * Cheap posture-change detector. Each batch is reduced to a mean gravity
+ * vector and a mean sample-to-sample motion energy. After the wrist has been
+ * still in a non-hanging posture, a burst of movement followed by the forearm
+ * hanging vertically (12 o'clock pointing down) for a few batches is treated
+ * as a stand-up.
+ */
+static void prv_accel_data_handler(AccelData *data, uint32_t num_samples) {
+  int32_t sum_y = 0;
+  int32_t energy = 0;
+  uint32_t used = 0;
+  uint32_t diffs = 0;
+  const AccelData *previous = NULL;
+
+  // Samples taken while the motor runs are dropped entirely, so a vibration
+  // burst (such as our own HR alert) never counts as movement
+  for (uint32_t index = 0; index < num_samples; index++) {
+    const AccelData *sample = &data[index];
+    if (sample->did_vibrate) {
+      continue;
+    }
+    sum_y += sample->y;
+    if (previous) {
+      energy += abs(sample->x - previous->x) +
+                abs(sample->y - previous->y) +
+                abs(sample->z - previous->z);
+      diffs++;
+    }
+    previous = sample;
+    used++;
+  }
+  if (diffs == 0) {
+    return;
+  }
+
+  int32_t mean_y = sum_y / (int32_t)used;
+  int32_t mean_energy = energy / (int32_t)diffs;
+  bool arm_hanging = mean_y <= ACCEL_ARM_HANGING_Y_MG;
+
+  if (mean_energy < ACCEL_STILL_ENERGY_MG) {
+    if (s_stand_confirm_batches > 0 && arm_hanging && !s_settled_arm_hanging) {
+      // Quiet hanging arm after the movement burst confirms the stand
+      if (++s_stand_confirm_batches > ACCEL_STAND_CONFIRM_BATCHES) {
+        s_stand_confirm_batches = 0;
+        s_settled = false;
+        s_still_batches = 0;
+        prv_start_stand_window();
+        return;
+      }
+    } else if (++s_still_batches >= ACCEL_SETTLED_BATCHES) {
+      s_settled = true;
+      s_settled_arm_hanging = arm_hanging;
+      s_stand_confirm_batches = 0;
+    }
+    return;
+  }
+
+  s_still_batches = 0;
+  if (mean_energy >= ACCEL_MOVE_ENERGY_MG && s_settled && !s_settled_arm_hanging) {
+    // Movement out of a settled sitting/lying posture; wait for confirmation
+    s_stand_confirm_batches = 1;
+  } else if (s_stand_confirm_batches > 0 && !arm_hanging) {
+    // Moving around without the arm dropping: not a stand-up
+    s_stand_confirm_batches = 0;
+    s_settled = false;
+  }
+}
+
+/**
+ * Reads current HR metrics, updates the display values, records raw samples,
+ * and evaluates the 60-second jump/drop alert. Inside a stand window the rise
+ * over the pre-stand baseline is also alert-worthy.
+ */
+static void prv_handle_heart_rate_update(void) {
+  s_last_filtered_hr = prv_get_heart_rate_metric(HealthMetricHeartRateBPM);
+  s_last_raw_hr = prv_get_heart_rate_metric(HealthMetricHeartRateRawBPM);
+
+  if (s_last_raw_hr > 0 && hr_outlier_filter_accept(&s_hr_filter, s_last_raw_hr)) {
+    time_t now = time(NULL);
+    hr_window_push(&s_hr_window, (uint32_t)now, s_last_raw_hr);
+
+    // A finished minute becomes one new sparkline column
+    HrBlock minute;
+    uint32_t skipped_minutes;
+    if (hr_blocks_add(&s_hr_blocks, (uint32_t)now, s_last_raw_hr, &minute, &skipped_minutes)) {
+      prv_push_spark_minute(&minute, skipped_minutes);
+    }
+    prv_account_hr_zone(s_last_raw_hr, now);
+    HrBlock short_window = hr_blocks_query(&s_hr_blocks, HR_SHORT_WINDOW_SEC);
+    HrBlock alert_window = hr_blocks_query(&s_hr_blocks, HR_ALERT_WINDOW_SEC);
+    HrBlock long_window = hr_blocks_query(&s_hr_blocks, HR_LONG_WINDOW_SEC);
+    s_last_short_window_delta = hr_block_spread(&short_window);
+    s_last_window_delta = hr_block_spread(&alert_window);
+    s_last_long_window_delta = hr_block_spread(&long_window);
+    s_last_window_slope = hr_window_slope_per_min(&s_hr_window);
+    s_last_window_mean = hr_window_mean(&s_hr_window);
+
+    uint32_t alert_delta = s_last_window_delta;
+    if (s_stand_active) {
+      int32_t stand_delta = s_last_raw_hr - s_stand_baseline_hr;
+      if (stand_delta > s_stand_peak_delta) {
+        s_stand_peak_delta = stand_delta;
+      }
+      if (stand_delta > (int32_t)alert_delta) {
+        alert_delta = (uint32_t)stand_delta;
+      }
+    }
+    prv_evaluate_hr_alert(alert_delta, s_last_window_slope);
+    if (s_hr_alert_active) {
+      prv_track_alert_event(s_last_raw_hr, alert_delta);
+    }
+  }
+
+  if (s_last_filtered_hr > 0 || s_last_raw_hr > 0) {
+    APP_LOG(APP_LOG_LEVEL_DEBUG,
+            "HR filtered=%lu raw=%lu delta=%lu/%lu/%lu slope=%ld mean=%ld rejected=%lu",
+            (uint32_t)s_last_filtered_hr, (uint32_t)s_last_raw_hr,
+            s_last_short_window_delta, s_last_window_delta, s_last_long_window_delta,
+            (long)s_last_window_slope,
+            (long)s_last_window_mean, s_hr_filter.rejected);
+  }
+
+  complications_mark_dirty(ComplicationHeartRate);
+}
+
+/**
+ * Finishes a baseline scan: persists the mean HR of the resting minutes found,
+ * or falls back to the health service's daily average when there were too few.
+ */
+static void prv_finish_baseline_scan(void) {
+  free(s_baseline_minutes);
+  s_baseline_minutes = NULL;
+
+  HealthValue bpm = 0;
+  if (s_baseline_scan_count >= BASELINE_MIN_REST_MINUTES) {
+    bpm = (HealthValue)(s_baseline_scan_sum / s_baseline_scan_count);
+  } else {
+    time_t end = time(NULL);
+    time_t start = end - BASELINE_HISTORY_SEC;
+    HealthServiceAccessibilityMask accessible =
+        health_service_metric_aggregate_averaged_accessible(HealthMetricHeartRateBPM, start, end,
+                                                            HealthAggregationMin,
+                                                            HealthServiceTimeScopeOnce);
+    if (accessible & HealthServiceAccessibilityMaskAvailable) {
+      bpm = health_service_aggregate_averaged(HealthMetricHeartRateBPM, start, end,
+                                              HealthAggregationMin, HealthServiceTimeScopeOnce);
+    }
+  }
+
+  if (bpm <= 0) {
+    APP_LOG(APP_LOG_LEVEL_WARNING, "Resting baseline unavailable");
+    return;
+  }
+
+  s_baseline.day_start = time_start_of_today();
+  s_baseline.bpm = bpm;
+  persist_write_data(BASELINE_KEY, &s_baseline, sizeof(s_baseline));
+  APP_LOG(APP_LOG_LEVEL_INFO, "Resting baseline=%ld from %lu rest minutes",
+          (long)bpm, s_baseline_scan_count);
+  complications_mark_dirty(ComplicationHeartRate);
+}
+
+/**
+ * Reads one chunk of minute history per timer tick so the scan never blocks
+ * the event loop for long. Minutes with HR, no steps and low movement count
+ * as resting, which covers sleep and quiet sitting.
+ */
+static void baseline_timer_callback(void *context) {
+  s_baseline_timer = NULL;
+
+  if (s_baseline_scan_start >= s_baseline_scan_end) {
+    prv_finish_baseline_scan();
+    return;
+  }
+
+  time_t chunk_start = s_baseline_scan_start;
+  time_t chunk_end = chunk_start + (BASELINE_CHUNK_MINUTES * SECONDS_PER_MINUTE);
+  if (chunk_end > s_baseline_scan_end) {
+    chunk_end = s_baseline_scan_end;
+  }
+
+  uint32_t records = health_service_get_minute_history(s_baseline_minutes, BASELINE_CHUNK_MINUTES,
+                                                       &chunk_start, &chunk_end);
+  for (uint32_t index = 0; index < records; index++) {
+    const HealthMinuteData *minute = &s_baseline_minutes[index];
+    if (!minute->is_invalid && minute->heart_rate_bpm > 0 && minute->steps == 0 &&
+        minute->vmc <= BASELINE_REST_MAX_VMC) {
+      s_baseline_scan_sum += minute->heart_rate_bpm;
+      s_baseline_scan_count++;
+    }
+  }
+
+  // Always move forward, even when the service returned nothing for the range
+  s_baseline_scan_start = chunk_end > s_baseline_scan_start
+      ? chunk_end
+      : s_baseline_scan_start + (BASELINE_CHUNK_MINUTES * SECONDS_PER_MINUTE);
+  s_baseline_timer = app_timer_register(power_interval(BASELINE_CHUNK_DELAY_MS),
+                                        baseline_timer_callback, NULL);
+}
+
+/**
+ * Starts a background baseline rebuild over the last day of minute history,
+ * unless one is already running or today's baseline is already known. On a
+ * red battery it waits; battery_callback retries once the watch is plugged
+ * in or recovers.
+ */
+static void prv_schedule_baseline_update(uint32_t delay_ms) {
+  if (s_baseline_timer || s_baseline_minutes || s_baseline.day_start == time_start_of_today() ||
+      !power_allows_heavy_work()) {
+    return;
+  }
+
+  s_baseline_minutes = malloc(sizeof(HealthMinuteData) * BASELINE_CHUNK_MINUTES);
+  if (!s_baseline_minutes) {
+    return;
+  }
+
+  s_baseline_scan_end = time(NULL);
+  s_baseline_scan_start = s_baseline_scan_end - BASELINE_HISTORY_SEC;
+  s_baseline_scan_sum = 0;
+  s_baseline_scan_count = 0;
+  s_baseline_timer = app_timer_register(delay_ms, baseline_timer_callback, NULL);
+}
+
+static void prv_load_baseline(void) {
+  s_baseline = (RestingBaseline) { 0 };
+  persist_read_data(BASELINE_KEY, &s_baseline, sizeof(s_baseline));
+}
+
+/**
+ * Re-reads today's step and activity totals. Returns true when either shown
+ * number changed.
+ */
+static bool prv_query_steps(time_t now) {
+  s_steps_pending = false;
+  s_steps_last_query = now;
+
+  HealthValue steps = health_service_sum_today(HealthMetricStepCount);
+  HealthValue active_minutes = health_service_sum_today(HealthMetricActiveSeconds) / 60;
+  bool changed = steps != s_steps_today || active_minutes != s_active_minutes_today;
+  s_steps_today = steps;
+  s_active_minutes_today = active_minutes;
+  return changed;
+}
+
+// Polled by the complication scheduler on each minute tick
+static bool prv_steps_is_stale(time_t now) {
+  return s_steps_pending && (now - s_steps_last_query) >= STEPS_QUERY_INTERVAL_SEC &&
+         prv_query_steps(now);
+}
+
+static void prv_handle_movement_update(bool significant) {
+  if (!complications_is_placed(ComplicationSteps)) {
+    return;
+  }
+
+  // Significant updates (midnight reset, history sync) bypass the throttle
+  time_t now = time(NULL);
+  if (!significant && (now - s_steps_last_query) < STEPS_QUERY_INTERVAL_SEC) {
+    s_steps_pending = true;
+    return;
+  }
+  if (prv_query_steps(now)) {
+    complications_mark_dirty(ComplicationSteps);
+  }
+}
+
+static void health_handler(HealthEventType event, void *context) {
+  if (event == HealthEventHeartRateUpdate) {
+    prv_handle_heart_rate_update();
+  } else if (event == HealthEventMovementUpdate) {
+    prv_handle_movement_update(false);
+  } else if (event == HealthEventSignificantUpdate) {
+    prv_handle_movement_update(true);
+  }
+}
+#endif
+
+// Set default settings
+static void prv_default_settings() {
+  settings.BackgroundColor = GColorBlack;
+  settings.TextColor = GColorWhite;
+  settings.TemperatureUnit = false; // Celsius
+  settings.ShowDate = true;
+  settings.SlopeAlert = false;
+  settings.SnoozeMinutes = SNOOZE_DEFAULT_MINUTES;
+  settings.TopSlot = ComplicationSun;
+  settings.LowerSlot = ComplicationHeartRate;
+  settings.BottomSlot = ComplicationWeather;
+  strncpy(settings.Language, "en", sizeof(settings.Language));
+  settings.BtAlertDelay = BT_ALERT_DELAY_DEFAULT_SEC;
+  settings.SettingsHash = 0; // Nothing received yet
+}
+
+// Save settings to persistent storage
+static void prv_save_settings() {
+  persist_write_data(SETTINGS_KEY, &settings, sizeof(settings));
+}
+
+// Read settings from persistent storage
+static void prv_load_settings() {
+  // Set defaults first
+  prv_default_settings();
+  // Then override with any saved values
+  persist_read_data(SETTINGS_KEY, &settings, sizeof(settings));
+}
+
+// Apply settings to UI elements
+static void prv_update_display() {
+  // Set background color
+  GColor bg_color = s_hr_alert_active ? PBL_IF_COLOR_ELSE(GColorRed, settings.BackgroundColor)
+                                      : settings.BackgroundColor;
+  window_set_background_color(s_main_window, bg_color);
+  #if defined(PBL_HEALTH) && defined(PBL_BW)
+  layer_set_hidden(s_alert_invert_layer, !s_hr_alert_active);
+  #endif
+
+  // Set text colors
+  layer_mark_dirty(s_time_layer);
+  text_layer_set_text_color(s_date_layer, settings.TextColor);
+  for (int slot = 0; slot < SlotCount; slot++) {
+    text_layer_set_text_color(s_slot_layers[slot], settings.TextColor);
+  }
+
+  // Show/hide date based on setting
+  layer_set_hidden(text_layer_get_layer(s_date_layer), !settings.ShowDate);
+
+  // Mark battery layer for redraw (color may have changed)
+  layer_mark_dirty(s_battery_layer);
+  #if defined(PBL_HEALTH)
+  layer_mark_dirty(s_zone_layer);
+  #endif
+}
+
+// Colour changes need every sparkline column and the weather icon re-tinted,
+// unlike alert toggles
+static void prv_update_colors() {
+  prv_update_display();
+  #if FEATURE_WEATHER_ICONS
+  prv_tint_weather_icon();
+  #endif
+  #if defined(PBL_HEALTH)
+  prv_rebuild_sparkline();
+  #endif
+}
+
+// Centres the time like the TextLayer it replaces; each glyph is a straight
+// bit copy into the frame buffer
+static void time_update_proc(Layer *layer, GContext *ctx) {
+  GRect bounds = layer_get_bounds(layer);
+  time_sprites_draw(ctx, layer, s_time_text, GPoint((bounds.size.w - s_time_width) / 2, 0),
+                    settings.TextColor);
+}
+
+static void update_time() {
+  time_t temp = time(NULL);
+  struct tm *tick_time = localtime(&temp);
+
+  char time_text[TIME_FORMAT_CLOCK_SIZE];
+  time_format_clock(time_text, sizeof(time_text), tick_time->tm_hour, tick_time->tm_min,
+                    clock_is_24h_style());
+  if (strcmp(time_text, s_time_text) != 0) {
+    memcpy(s_time_text, time_text, sizeof(s_time_text));
+    s_time_width = time_sprites_width(s_time_text);
+    layer_mark_dirty(s_time_layer);
+  }
+
+  // The date only changes once a day
+  static char s_date_buffer[TIME_FORMAT_DATE_SIZE];
+  if (tick_time->tm_yday != s_date_layer_yday) {
+    s_date_layer_yday = tick_time->tm_yday;
+    time_format_date(s_date_buffer, sizeof(s_date_buffer), tick_time, l10n_day_names(),
+                     l10n_month_names());
+    text_layer_set_text(s_date_layer, s_date_buffer);
+  }
+}
+
+// Writes the local clock time for a UTC time, returning the length written
+static int prv_format_clock(char *buffer, size_t size, time_t utc) {
+  struct tm *local = localtime(&utc);
+  return (int)time_format_clock(buffer, size, local->tm_hour, local->tm_min,
+                                clock_is_24h_style());
+}
+
+// Computes today's sunrise, sunset and day length from the cached location.
+// Only re-rendered when the day or the location changes; never per minute.
+static void prv_render_sun(char *buffer, size_t size) {
+  if (!s_sun_location.valid) {
+    buffer[0] = '\0';
+    return;
+  }
+
+  time_t now = time(NULL);
+  struct tm *today = localtime(&now);
+  int yday = today->tm_yday;
+  s_sun_yday = yday;
+  time_t utc_midnight = solar_utc_midnight(today->tm_year + 1900, today->tm_mon + 1,
+                                           today->tm_mday);
+
+  int32_t sunrise_sec;
+  int32_t sunset_sec;
+  SolarDay day = solar_compute(s_sun_location.lat_e2, s_sun_location.lon_e2, yday,
+                               &sunrise_sec, &sunset_sec);
+  if (day == SolarDayPolarDay) {
+    snprintf(buffer, size, "Sun up all day");
+  } else if (day == SolarDayPolarNight) {
+    snprintf(buffer, size, "Sun down all day");
+  } else {
+    int32_t daylight_min = (sunset_sec - sunrise_sec) / 60;
+    int length = prv_format_clock(buffer, size,
+                                  utc_midnight + sunrise_sec);
+    length += snprintf(buffer + length, size - length, " - ");
+    length += prv_format_clock(buffer + length, size - length,
+                               utc_midnight + sunset_sec);
+    snprintf(buffer + length, size - length, "  %ldh%02ld",
+             (long)(daylight_min / 60), (long)(daylight_min % 60));
+  }
+}
+
+static bool prv_sun_is_stale(time_t now) {
+  return localtime(&now)->tm_yday != s_sun_yday;
+}
+
+static void prv_render_date(char *buffer, size_t size) {
+  time_t now = time(NULL);
+  struct tm *today = localtime(&now);
+  s_date_yday = today->tm_yday;
+  time_format_date(buffer, size, today, l10n_day_names(), l10n_month_names());
+}
 
-  if (active) {
-    s_hr_alert_timer = app_timer_register(HR_ALERT_WINDOW_SEC * 1000, hr_alert_timer_callback, NULL);
-  }
+static bool prv_date_is_stale(time_t now) {
+  return localtime(&now)->tm_yday != s_date_yday;
 }
 
-static void hr_alert_timer_callback(void *context) {
-  s_hr_alert_timer = NULL;
-  s_hr_alert_active = false;
-  prv_update_display();
+// Open-Meteo reports WMO weather interpretation codes
+static L10nString prv_weather_condition(int code) {
+  if (code == 0) return L10nConditionClear;
+  if (code <= 3) return L10nConditionCloudy;
+  if (code <= 48) return L10nConditionFog;
+  if (code <= 55) return L10nConditionDrizzle;
+  if (code <= 57) return L10nConditionFreezingDrizzle;
+  if (code <= 65) return L10nConditionRain;
+  if (code <= 67) return L10nConditionFreezingRain;
+  if (code <= 75) return L10nConditionSnow;
+  if (code <= 77) return L10nConditionSnowGrains;
+  if (code <= 82) return L10nConditionShowers;
+  if (code <= 86) return L10nConditionSnowShowers;
+  if (code <= 99) return L10nConditionThunderstorm;
+  return L10nConditionUnknown;
 }
-#endif
 
-#if defined(PBL_HEALTH)
-/**
- * Returns the current heart-rate value for the given metric when available,
- * otherwise 0. This centralizes accessibility checks for both filtered and
- * raw BPM queries.
- */
-static HealthValue prv_get_heart_rate_metric(HealthMetric metric) {
-  HealthServiceAccessibilityMask accessible =
-      health_service_metric_accessible(metric, time(NULL), time(NULL));
-  if (!(accessible & HealthServiceAccessibilityMaskAvailable)) {
-    return 0;
+// Icons are drawn beside the lower slots only; the top slot is too short
+static bool prv_weather_icon_shown(void) {
+  #if !FEATURE_WEATHER_ICONS
+  return false;
+  #else
+  int slot = complications_slot_of(ComplicationWeather);
+  return slot == SlotLower || slot == SlotBottom;
+  #endif
+}
+
+#if FEATURE_WEATHER_ICONS
+// Icon resource for a WMO code, or 0 for conditions without one
+static uint32_t prv_weather_icon_resource(int code) {
+  switch (prv_weather_condition(code)) {
+    case L10nConditionClear:
+      return RESOURCE_ID_IMAGE_WX_CLEAR;
+    case L10nConditionCloudy:
+      return RESOURCE_ID_IMAGE_WX_CLOUDY;
+    case L10nConditionFog:
+      return RESOURCE_ID_IMAGE_WX_FOG;
+    case L10nConditionDrizzle:
+    case L10nConditionFreezingDrizzle:
+      return RESOURCE_ID_IMAGE_WX_DRIZZLE;
+    case L10nConditionRain:
+    case L10nConditionFreezingRain:
+    case L10nConditionShowers:
+      return RESOURCE_ID_IMAGE_WX_RAIN;
+    case L10nConditionSnow:
+    case L10nConditionSnowGrains:
+    case L10nConditionSnowShowers:
+      return RESOURCE_ID_IMAGE_WX_SNOW;
+    case L10nConditionThunderstorm:
+      return RESOURCE_ID_IMAGE_WX_STORM;
+    default:
+      return 0;
   }
+}
 
-  HealthValue value = health_service_peek_current_value(metric);
-  return value > 0 ? value : 0;
+// Icons are authored in white; strokes and non-transparent fills take the text colour
+static bool prv_tint_draw_command(GDrawCommand *command, uint32_t index, void *context) {
+  GColor color = *(GColor *)context;
+  gdraw_command_set_stroke_color(command, color);
+  if (!gcolor_equal(gdraw_command_get_fill_color(command), GColorClear)) {
+    gdraw_command_set_fill_color(command, color);
+  }
+  return true;
 }
 
-/**
- * Removes raw HR samples that are older than the configured alert window.
- */
-static void prv_prune_old_hr_samples(time_t now) {
-  while (s_hr_sample_count > 0 && (now - s_hr_sample_times[0]) > HR_ALERT_WINDOW_SEC) {
-    for (int index = 1; index < s_hr_sample_count; index++) {
-      s_hr_sample_times[index - 1] = s_hr_sample_times[index];
-      s_hr_sample_values[index - 1] = s_hr_sample_values[index];
-    }
-    s_hr_sample_count--;
+static void prv_tint_weather_icon(void) {
+  if (!s_weather_icon) {
+    return;
   }
+  GColor color = settings.TextColor;
+  gdraw_command_list_iterate(gdraw_command_image_get_command_list(s_weather_icon),
+                             prv_tint_draw_command, &color);
+  layer_mark_dirty(s_weather_icon_layer);
 }
 
 /**
- * Stores a new raw HR sample and keeps the sample buffer bounded.
+ * Swaps in the icon for the current condition, freeing the previous one.
+ * Nothing is loaded while no icon is shown.
  */
-static void prv_store_raw_hr_sample(HealthValue raw_hr, time_t now) {
-  if (raw_hr <= 0) {
+static void prv_update_weather_icon(void) {
+  uint32_t resource_id = 0;
+  if (s_weather_valid && prv_weather_icon_shown()) {
+    resource_id = prv_weather_icon_resource(s_weather_code);
+  }
+  if (resource_id == s_weather_icon_id) {
     return;
   }
 
-  prv_prune_old_hr_samples(now);
+  if (s_weather_icon) {
+    gdraw_command_image_destroy(s_weather_icon);
+    s_weather_icon = NULL;
+  }
+  s_weather_icon_id = resource_id;
+  if (resource_id != 0) {
+    s_weather_icon = gdraw_command_image_create_with_resource(resource_id);
+    prv_tint_weather_icon();
+  }
+  prv_update_fit_widths();
+  layer_mark_dirty(s_weather_icon_layer);
+}
 
-  if (s_hr_sample_count >= HR_SAMPLE_BUFFER_SIZE) {
-    for (int index = 1; index < s_hr_sample_count; index++) {
-      s_hr_sample_times[index - 1] = s_hr_sample_times[index];
-      s_hr_sample_values[index - 1] = s_hr_sample_values[index];
-    }
-    s_hr_sample_count--;
+// Draws the icon just left of the centred weather text
+static void weather_icon_update_proc(Layer *layer, GContext *ctx) {
+  int slot = complications_slot_of(ComplicationWeather);
+  if (!s_weather_icon || slot < 0) {
+    return;
   }
 
-  s_hr_sample_times[s_hr_sample_count] = now;
-  s_hr_sample_values[s_hr_sample_count] = raw_hr;
-  s_hr_sample_count++;
+  GRect bounds = layer_get_bounds(layer);
+  GSize text_size = text_layer_get_content_size(s_slot_layers[slot]);
+  GSize icon_size = gdraw_command_image_get_bounds_size(s_weather_icon);
+  int x = ((bounds.size.w - text_size.w) / 2) - icon_size.w - WEATHER_ICON_GAP;
+  gdraw_command_image_draw(ctx, s_weather_icon,
+                           GPoint(x, (bounds.size.h - icon_size.h) / 2));
 }
+#endif
 
-/**
- * Calculates max-min BPM from the raw HR samples in the current alert window.
- * This catches both sudden rises and sudden drops quickly.
- */
-static uint32_t prv_calculate_window_delta_bpm(void) {
-  if (s_hr_sample_count < 2) {
-    return 0;
-  }
+static void prv_render_weather(char *buffer, size_t size) {
+  #if FEATURE_WEATHER_ICONS
+  prv_update_weather_icon();
+  #endif
 
-  HealthValue min_value = s_hr_sample_values[0];
-  HealthValue max_value = s_hr_sample_values[0];
+  if (!s_weather_valid) {
+    snprintf(buffer, size, "%s", l10n_get(L10nLoading));
+    return;
+  }
 
-  for (int index = 1; index < s_hr_sample_count; index++) {
-    if (s_hr_sample_values[index] < min_value) {
-      min_value = s_hr_sample_values[index];
-    }
-    if (s_hr_sample_values[index] > max_value) {
-      max_value = s_hr_sample_values[index];
-    }
+  // The icon stands in for the condition name when there is one
+  const char *condition = l10n_get(prv_weather_condition(s_weather_code));
+  #if FEATURE_WEATHER_ICONS
+  if (s_weather_icon) {
+    condition = "";
   }
+  #endif
 
-  return (uint32_t)(max_value - min_value);
+  // Convert to Fahrenheit if setting is enabled
+  if (settings.TemperatureUnit) {
+    snprintf(buffer, size, "%d°F%s%s", (s_weather_temp_c * 9 / 5) + 32,
+             condition[0] ? " " : "", condition);
+  } else {
+    snprintf(buffer, size, "%d°C%s%s", s_weather_temp_c, condition[0] ? " " : "", condition);
+  }
 }
 
-/**
- * Applies alert rules for the latest computed window delta. If the threshold is
- * met, background alert is activated and vibration is emitted once per event.
- */
-static void prv_evaluate_hr_alert(uint32_t delta_bpm) {
-  if (delta_bpm < HR_ALERT_DELTA_BPM) {
-    return;
+static void prv_render_steps(char *buffer, size_t size) {
+  #if defined(PBL_HEALTH)
+  // Events are ignored while unplaced, so the cache may be stale when the
+  // complication is first placed
+  time_t now = time(NULL);
+  if ((now - s_steps_last_query) >= STEPS_QUERY_INTERVAL_SEC) {
+    prv_query_steps(now);
   }
+  snprintf(buffer, size, "%ld steps  %ld min", (long)s_steps_today,
+           (long)s_active_minutes_today);
+  #else
+  snprintf(buffer, size, "-- steps");
+  #endif
+}
 
-  if (!s_hr_alert_active) {
-    vibes_short_pulse();
-  }
-  prv_set_hr_alert_active(true);
+#if FEATURE_SECOND_ZONE
+static void prv_request_second_zone(void) {
+  phone_link_request(PhoneRequestSecondZone);
 }
 
 /**
- * Reads current HR metrics, updates the display values, records raw samples,
- * and evaluates the 60-second jump/drop alert.
+ * Renders the second clock from the cached offset: an add and a divide per
+ * minute, no localtime. Crossing the cached DST change swaps in the next
+ * offset and asks the phone for the one after it.
  */
-static void prv_handle_heart_rate_update(void) {
-  s_last_filtered_hr = prv_get_heart_rate_metric(HealthMetricHeartRateBPM);
-  s_last_raw_hr = prv_get_heart_rate_metric(HealthMetricHeartRateRawBPM);
+static void prv_render_second_time(char *buffer, size_t size) {
+  if (!s_second_zone.valid) {
+    snprintf(buffer, size, "Set a zone");
+    return;
+  }
 
-  if (s_last_raw_hr > 0) {
-    time_t now = time(NULL);
-    prv_store_raw_hr_sample(s_last_raw_hr, now);
-    s_last_window_delta = prv_calculate_window_delta_bpm();
-    prv_evaluate_hr_alert(s_last_window_delta);
+  time_t now = time(NULL);
+  if (s_second_zone.next_change != 0 && now >= s_second_zone.next_change) {
+    s_second_zone.offset_min = s_second_zone.next_offset_min;
+    s_second_zone.next_change = 0;
+    persist_write_data(SECOND_ZONE_KEY, &s_second_zone, sizeof(s_second_zone));
+    prv_request_second_zone();
   }
 
-  if (s_last_filtered_hr > 0 || s_last_raw_hr > 0) {
-    APP_LOG(APP_LOG_LEVEL_DEBUG, "HR filtered=%lu raw=%lu delta=%lu", (uint32_t)s_last_filtered_hr,
-            (uint32_t)s_last_raw_hr, (uint32_t)s_last_window_delta);
+  int32_t minute_of_day = (int32_t)(((now / 60) + s_second_zone.offset_min) % (24 * 60));
+  if (minute_of_day < 0) {
+    minute_of_day += 24 * 60;
   }
+  int length = snprintf(buffer, size, "%s ", s_second_zone.label);
+  time_format_clock(buffer + length, size - length, minute_of_day / 60, minute_of_day % 60,
+                    clock_is_24h_style());
+}
 
-  prv_update_hr_display();
+// The minute changed, so the second clock always needs a redraw on the tick
+static bool prv_second_time_is_stale(time_t now) {
+  return true;
 }
 
-static void health_handler(HealthEventType event, void *context) {
-  if (event == HealthEventHeartRateUpdate) {
-    prv_handle_heart_rate_update();
-  }
+static void prv_load_second_zone(void) {
+  s_second_zone = (SecondZone) { .valid = false };
+  persist_read_data(SECOND_ZONE_KEY, &s_second_zone, sizeof(s_second_zone));
 }
 #endif
 
-// Set default settings
-static void prv_default_settings() {
-  settings.BackgroundColor = GColorBlack;
-  settings.TextColor = GColorWhite;
-  settings.TemperatureUnit = false; // Celsius
-  settings.ShowDate = true;
+static void prv_render_battery(char *buffer, size_t size) {
+  snprintf(buffer, size, "Battery %d%%", s_battery_level);
 }
 
-// Save settings to persistent storage
-static void prv_save_settings() {
-  persist_write_data(SETTINGS_KEY, &settings, sizeof(settings));
+static void prv_load_weather(void) {
+  CachedWeather cached = { 0 };
+  persist_read_data(WEATHER_KEY, &cached, sizeof(cached));
+  s_weather_time = cached.time;
+  s_weather_valid = cached.time != 0 && time(NULL) - cached.time < WEATHER_DISPLAY_MAX_AGE_SEC;
+  s_weather_temp_c = cached.temp_c;
+  s_weather_code = cached.code;
 }
 
-// Read settings from persistent storage
-static void prv_load_settings() {
-  // Set defaults first
-  prv_default_settings();
-  // Then override with any saved values
-  persist_read_data(SETTINGS_KEY, &settings, sizeof(settings));
+static void prv_load_sun_location(void) {
+  s_sun_location = (SunLocation) { .valid = false };
+  persist_read_data(LOCATION_KEY, &s_sun_location, sizeof(s_sun_location));
 }
 
-// Apply settings to UI elements
-static void prv_update_display() {
-  // Set background color
-  GColor bg_color = s_hr_alert_active ? PBL_IF_COLOR_ELSE(GColorRed, settings.BackgroundColor)
-                                      : settings.BackgroundColor;
-  window_set_background_color(s_main_window, bg_color);
+// Caches a new fix, skipping the flash write and recompute for small moves
+static void prv_set_sun_location(int32_t lat_e2, int32_t lon_e2) {
+  if (s_sun_location.valid &&
+      abs(lat_e2 - s_sun_location.lat_e2) < LOCATION_MIN_MOVE_E2 &&
+      abs(lon_e2 - s_sun_location.lon_e2) < LOCATION_MIN_MOVE_E2) {
+    return;
+  }
 
-  // Set text colors
-  text_layer_set_text_color(s_time_layer, settings.TextColor);
-  text_layer_set_text_color(s_date_layer, settings.TextColor);
-  text_layer_set_text_color(s_hr_layer, settings.TextColor);
-  text_layer_set_text_color(s_weather_layer, settings.TextColor);
+  s_sun_location = (SunLocation) { .lat_e2 = lat_e2, .lon_e2 = lon_e2, .valid = true };
+  persist_write_data(LOCATION_KEY, &s_sun_location, sizeof(s_sun_location));
+  complications_mark_dirty(ComplicationSun);
+}
 
-  // Show/hide date based on setting
-  layer_set_hidden(text_layer_get_layer(s_date_layer), !settings.ShowDate);
+// Indexed by ComplicationId. Costs are rough budget units: the sun times run
+// the trig series, the rest are a single snprintf.
+static const Complication s_complications[ComplicationCount] = {
+  [ComplicationHeartRate] = { .render = prv_render_hr, .min_interval_sec = 1, .cost = 1 },
+  [ComplicationWeather] = { .render = prv_render_weather, .cost = 1 },
+  [ComplicationSun] = { .render = prv_render_sun, .is_stale = prv_sun_is_stale,
+                        .min_interval_sec = 60, .cost = 4 },
+  [ComplicationDate] = { .render = prv_render_date, .is_stale = prv_date_is_stale,
+                         .min_interval_sec = 60, .cost = 1 },
+  [ComplicationBattery] = { .render = prv_render_battery, .min_interval_sec = 60, .cost = 1 },
+#if FEATURE_SECOND_ZONE
+  [ComplicationSecondTime] = { .render = prv_render_second_time,
+                               .is_stale = prv_second_time_is_stale, .cost = 1 },
+#endif
+#if defined(PBL_HEALTH)
+  [ComplicationSteps] = { .render = prv_render_steps, .is_stale = prv_steps_is_stale,
+                          .min_interval_sec = 60, .cost = 2 },
+#else
+  [ComplicationSteps] = { .render = prv_render_steps, .cost = 1 },
+#endif
+};
 
-  // Mark battery layer for redraw (color may have changed)
-  layer_mark_dirty(s_battery_layer);
+// Weather requests also deliver the coordinates the sun times need
+static bool prv_weather_wanted(void) {
+  return complications_is_placed(ComplicationWeather) ||
+         complications_is_placed(ComplicationSun);
 }
 
-static void update_time() {
-  time_t temp = time(NULL);
-  struct tm *tick_time = localtime(&temp);
+static void prv_request_weather(void) {
+  if (!prv_weather_wanted()) {
+    return;
+  }
+  // Counts as requested while disconnected too; the reconnect replays it
+  s_weather_last_request = time(NULL);
+  phone_link_request(PhoneRequestWeather);
+}
 
-  static char s_time_buffer[8];
-  strftime(s_time_buffer, sizeof(s_time_buffer), clock_is_24h_style() ?
-                                                    "%H:%M" : "%I:%M", tick_time);
-  text_layer_set_text(s_time_layer, s_time_buffer);
+/**
+ * Tells PebbleKit JS what the watch already has: the protocol version, the
+ * age of the cached weather (only while something shows it, -1 for none)
+ * with the power-scaled refresh interval to judge it by, the hash of the last
+ * settings it received, whether it lacks second-zone data and the newest HR
+ * log entry. JS then fetches or pushes only what is missing.
+ */
+static void prv_write_hello(DictionaryIterator *iter) {
+  dict_write_uint8(iter, MESSAGE_KEY_HELLO, PROTOCOL_VERSION);
+  dict_write_uint32(iter, MESSAGE_KEY_SETTINGS_HASH, settings.SettingsHash);
+  if (prv_weather_wanted()) {
+    time_t now = time(NULL);
+    uint32_t interval = power_interval(WEATHER_INTERVAL_SEC);
+    int32_t age = s_weather_time != 0 ? (int32_t)(now - s_weather_time) : -1;
+    dict_write_int32(iter, MESSAGE_KEY_WEATHER_AGE, age);
+    dict_write_uint32(iter, MESSAGE_KEY_WEATHER_INTERVAL, interval);
+    // JS fetches on a stale age, so the tick must not ask again straight away
+    if (age < 0 || (uint32_t)age >= interval) {
+      s_weather_last_request = now;
+    }
+  }
+  #if FEATURE_SECOND_ZONE
+  if (!persist_exists(SECOND_ZONE_KEY)) {
+    dict_write_uint8(iter, MESSAGE_KEY_TZ_REQUEST, 1);
+  }
+  #endif
+  #if defined(PBL_HEALTH)
+  dict_write_uint32(iter, MESSAGE_KEY_HR_LOG_LAST, s_hr_log_next_seq - 1);
+  #endif
+}
 
-  static char s_date_buffer[16];
-  strftime(s_date_buffer, sizeof(s_date_buffer), "%a %b %d", tick_time);
-  text_layer_set_text(s_date_layer, s_date_buffer);
+// Every request PebbleKit JS answers rides in one message, so a replay after
+// a reconnect costs a single send
+static void prv_write_phone_requests(DictionaryIterator *iter, uint32_t requests) {
+  if (requests & PhoneRequestHello) {
+    prv_write_hello(iter);
+  }
+  if (requests & PhoneRequestWeather) {
+    dict_write_uint8(iter, MESSAGE_KEY_REQUEST_WEATHER, 1);
+  }
+  if (requests & PhoneRequestSecondZone) {
+    dict_write_uint8(iter, MESSAGE_KEY_TZ_REQUEST, 1);
+  }
 }
 
 static void tick_handler(struct tm *tick_time, TimeUnits units_changed) {
   update_time();
 
-  // Get weather update every 30 minutes
-  if (tick_time->tm_min % 30 == 0) {
-    DictionaryIterator *iter;
-    app_message_outbox_begin(&iter);
-    dict_write_uint8(iter, MESSAGE_KEY_REQUEST_WEATHER, 1);
-    app_message_outbox_send();
+  complications_minute_tick(time(NULL));
+
+  #if defined(PBL_HEALTH)
+  // Rebuild the resting baseline once per day, off the per-second HR path
+  if (units_changed & DAY_UNIT) {
+    prv_schedule_baseline_update(BASELINE_CHUNK_DELAY_MS);
+    prv_reset_zone_totals();
+  }
+  #endif
+
+  // Get weather update every 30 minutes, more often on the charger and less
+  // often on a low battery
+  if (time(NULL) - s_weather_last_request >= (time_t)power_interval(WEATHER_INTERVAL_SEC)) {
+    prv_request_weather();
   }
 }
 
 static void battery_callback(BatteryChargeState state) {
   s_battery_level = state.charge_percent;
   layer_mark_dirty(s_battery_layer);
+  complications_mark_dirty(ComplicationBattery);
+
+  if (!power_update(state)) {
+    return;
+  }
+
+  #if defined(PBL_HEALTH)
+  // Work held back on a red battery starts as soon as it is allowed, and
+  // pending log writes go out while the charger pays for them
+  prv_schedule_baseline_update(BASELINE_CHUNK_DELAY_MS);
+  if (power_level() == PowerLevelPlugged) {
+    prv_hr_log_flush();
+  }
+  #endif
 }
 
 static void battery_update_proc(Layer *layer, GContext *ctx) {
@@ -296,9 +1780,9 @@ static void battery_update_proc(Layer *layer, GContext *ctx) {
 
   // Choose color based on battery level
   GColor bar_color;
-  if (s_battery_level <= 20) {
+  if (s_battery_level <= POWER_CRITICAL_PERCENT) {
     bar_color = PBL_IF_COLOR_ELSE(GColorRed, settings.TextColor);
-  } else if (s_battery_level <= 40) {
+  } else if (s_battery_level <= POWER_LOW_PERCENT) {
     bar_color = PBL_IF_COLOR_ELSE(GColorChromeYellow, settings.TextColor);
   } else {
     bar_color = PBL_IF_COLOR_ELSE(GColorGreen, settings.TextColor);
@@ -310,41 +1794,196 @@ static void battery_update_proc(Layer *layer, GContext *ctx) {
 }
 
 static void bluetooth_callback(bool connected) {
-  // Show icon if disconnected
+  // Show icon if disconnected; it takes the top slot's place
   layer_set_hidden(bitmap_layer_get_layer(s_bt_icon_layer), connected);
+  layer_set_hidden(text_layer_get_layer(s_slot_layers[SlotTop]), !connected);
+}
+
+// Only once the link has stayed down for the grace period, so a flapping
+// connection does not buzz on every drop
+static void bluetooth_alert_callback(void) {
+  vibes_double_pulse();
+}
+
+// Vertical position of each slot. The lower and bottom slots follow the given
+// (unobstructed) bounds; the top slot sits just under the battery bar.
+static int prv_slot_y(int slot, GRect bounds) {
+  switch (slot) {
+    case SlotTop:
+      return PBL_IF_ROUND_ELSE(bounds.size.h / 8, bounds.size.h / 28) + 10;
+    case SlotLower:
+      return bounds.size.h - PBL_IF_ROUND_ELSE(60, 50);
+    default:
+      return bounds.size.h - PBL_IF_ROUND_ELSE(40, 30);
+  }
+}
+
+#if defined(PBL_ROUND)
+static int prv_isqrt(int value) {
+  int root = 0;
+  while ((root + 1) * (root + 1) <= value) {
+    root++;
+  }
+  return root;
+}
+#endif
+
+// Width a slot's text may take: the frame on rectangular screens, the
+// narrowest chord across the text band on round ones. The weather slot also
+// leaves room for the icon on both sides so the text stays centred.
+static void prv_update_fit_widths(void) {
+  for (int slot = 0; slot < SlotCount; slot++) {
+    GRect frame = layer_get_frame(text_layer_get_layer(s_slot_layers[slot]));
+    int width = frame.size.w;
+
+    #if defined(PBL_ROUND)
+    GRect screen = layer_get_bounds(s_window_layer);
+    int radius = screen.size.w / 2;
+    int center_y = screen.size.h / 2;
+    // Glyphs start a few pixels below the top of a TextLayer
+    int top = abs(frame.origin.y + 4 - center_y);
+    int bottom = abs(frame.origin.y + frame.size.h - center_y);
+    int distance = top > bottom ? top : bottom;
+    int chord = distance < radius ? 2 * prv_isqrt((radius * radius) - (distance * distance)) : 0;
+    width = (chord < width ? chord : width) - 4;
+    #endif
+
+    #if FEATURE_WEATHER_ICONS
+    if (s_weather_icon && complications_slot_of(ComplicationWeather) == slot) {
+      width -= 2 * (gdraw_command_image_get_bounds_size(s_weather_icon).w + WEATHER_ICON_GAP);
+    }
+    #endif
+
+    s_slot_fits[slot].width = width;
+  }
+}
+
+// The HR zone bar and sparkline travel with the HR complication and are
+// hidden, and not rendered, when it is not in one of the lower slots.
+static void prv_layout_hr_extras(void) {
+  #if defined(PBL_HEALTH)
+  int slot = complications_slot_of(ComplicationHeartRate);
+  bool shown = slot == SlotLower || slot == SlotBottom;
+  bool was_hidden = layer_get_hidden(s_spark_layer);
+  layer_set_hidden(s_zone_layer, !shown);
+  layer_set_hidden(s_spark_layer, !shown);
+  if (!shown) {
+    return;
+  }
+
+  int hr_y = layer_get_frame(text_layer_get_layer(s_slot_layers[slot])).origin.y;
+  GRect zone_frame = layer_get_frame(s_zone_layer);
+  zone_frame.origin.y = hr_y - 3;
+  layer_set_frame(s_zone_layer, zone_frame);
+
+  GRect spark_frame = layer_get_frame(s_spark_layer);
+  spark_frame.origin.y = hr_y + 2;
+  layer_set_frame(s_spark_layer, spark_frame);
+
+  // Columns were not drawn while hidden and the split is from the old head
+  if (was_hidden) {
+    prv_rebuild_sparkline();
+  }
+  #endif
+}
 
-  if (!connected) {
-    vibes_double_pulse();
+// The weather icon follows the weather complication into the lower slots
+static void prv_layout_weather_icon(void) {
+  #if FEATURE_WEATHER_ICONS
+  int slot = complications_slot_of(ComplicationWeather);
+  bool shown = prv_weather_icon_shown();
+  layer_set_hidden(s_weather_icon_layer, !shown);
+  if (shown) {
+    GRect text_frame = layer_get_frame(text_layer_get_layer(s_slot_layers[slot]));
+    GRect icon_frame = layer_get_frame(s_weather_icon_layer);
+    icon_frame.origin.y = text_frame.origin.y + 3;
+    layer_set_frame(s_weather_icon_layer, icon_frame);
   }
+  #endif
+}
+
+// Binds each slot's TextLayer to the complication chosen in settings
+static void prv_apply_slots(void) {
+  complications_place(SlotTop, settings.TopSlot, s_slot_layers[SlotTop]);
+  complications_place(SlotLower, settings.LowerSlot, s_slot_layers[SlotLower]);
+  complications_place(SlotBottom, settings.BottomSlot, s_slot_layers[SlotBottom]);
+  prv_layout_hr_extras();
+  prv_layout_weather_icon();
+  prv_update_fit_widths();
+
+  // Re-render so the text gains or drops the condition name with the icon
+  complications_mark_dirty(ComplicationWeather);
+}
+
+// Clay sends select values as strings
+static uint8_t prv_tuple_complication(const Tuple *tuple) {
+  int32_t value = tuple->type == TUPLE_CSTRING ? atoi(tuple->value->cstring)
+                                                : tuple->value->int32;
+  return (value > ComplicationNone && value < ComplicationCount) ? (uint8_t)value
+                                                                : ComplicationNone;
 }
 
 // AppMessage received handler
 static void inbox_received_callback(DictionaryIterator *iterator, void *context) {
   // Check for weather data
   Tuple *temp_tuple = dict_find(iterator, MESSAGE_KEY_TEMPERATURE);
-  Tuple *conditions_tuple = dict_find(iterator, MESSAGE_KEY_CONDITIONS);
-
-  if (temp_tuple && conditions_tuple) {
-    static char temperature_buffer[8];
-    static char conditions_buffer[32];
-    static char weather_layer_buffer[32];
+  Tuple *weather_code_tuple = dict_find(iterator, MESSAGE_KEY_WEATHER_CODE);
+
+  if (temp_tuple && weather_code_tuple) {
+    s_weather_temp_c = (int)temp_tuple->value->int32;
+    s_weather_code = (int)weather_code_tuple->value->int32;
+    s_weather_valid = true;
+    s_weather_time = time(NULL);
+    s_weather_last_request = s_weather_time;
+    CachedWeather cached = {
+      .time = s_weather_time,
+      .temp_c = (int16_t)s_weather_temp_c,
+      .code = (int16_t)s_weather_code,
+    };
+    persist_write_data(WEATHER_KEY, &cached, sizeof(cached));
+    complications_mark_dirty(ComplicationWeather);
+  }
 
-    int temp_value = (int)temp_tuple->value->int32;
+  // Coordinates ride along with the weather reply
+  Tuple *latitude_t = dict_find(iterator, MESSAGE_KEY_LATITUDE);
+  Tuple *longitude_t = dict_find(iterator, MESSAGE_KEY_LONGITUDE);
+  if (latitude_t && longitude_t) {
+    prv_set_sun_location(latitude_t->value->int32, longitude_t->value->int32);
+  }
 
-    // Convert to Fahrenheit if setting is enabled
-    if (settings.TemperatureUnit) {
-      temp_value = (temp_value * 9 / 5) + 32;
-      snprintf(temperature_buffer, sizeof(temperature_buffer), "%d°F", temp_value);
-    } else {
-      snprintf(temperature_buffer, sizeof(temperature_buffer), "%d°C", temp_value);
+  #if FEATURE_SECOND_ZONE
+  // Second time zone, resolved on the phone. An empty label clears it.
+  Tuple *tz_label_t = dict_find(iterator, MESSAGE_KEY_TZ_LABEL);
+  if (tz_label_t) {
+    Tuple *tz_offset_t = dict_find(iterator, MESSAGE_KEY_TZ_OFFSET);
+    Tuple *tz_next_change_t = dict_find(iterator, MESSAGE_KEY_TZ_NEXT_CHANGE);
+    Tuple *tz_next_offset_t = dict_find(iterator, MESSAGE_KEY_TZ_NEXT_OFFSET);
+    s_second_zone = (SecondZone) { .valid = tz_offset_t && tz_label_t->value->cstring[0] };
+    if (s_second_zone.valid) {
+      s_second_zone.offset_min = tz_offset_t->value->int32;
+      s_second_zone.next_change = tz_next_change_t ? (time_t)tz_next_change_t->value->int32 : 0;
+      s_second_zone.next_offset_min = tz_next_offset_t ? tz_next_offset_t->value->int32
+                                                      : s_second_zone.offset_min;
+      snprintf(s_second_zone.label, sizeof(s_second_zone.label), "%s",
+               tz_label_t->value->cstring);
     }
+    persist_write_data(SECOND_ZONE_KEY, &s_second_zone, sizeof(s_second_zone));
+    complications_mark_dirty(ComplicationSecondTime);
+  }
+  #endif
 
-    snprintf(conditions_buffer, sizeof(conditions_buffer), "%s", conditions_tuple->value->cstring);
-    snprintf(weather_layer_buffer, sizeof(weather_layer_buffer), "%s %s", temperature_buffer, conditions_buffer);
-    text_layer_set_text(s_weather_layer, weather_layer_buffer);
+  #if defined(PBL_HEALTH)
+  // PebbleKit JS pulls the HR event log from the given sequence number
+  Tuple *hr_log_request_t = dict_find(iterator, MESSAGE_KEY_HR_LOG_REQUEST);
+  if (hr_log_request_t) {
+    prv_hr_log_start_export((uint32_t)hr_log_request_t->value->int32);
   }
+  #endif
 
   // Check for Clay settings data
+  // Clay sends every key on each save, so compare rather than test presence
+  GColor old_background = settings.BackgroundColor;
+  GColor old_text = settings.TextColor;
   Tuple *bg_color_t = dict_find(iterator, MESSAGE_KEY_BackgroundColor);
   if (bg_color_t) {
     settings.BackgroundColor = GColorFromHEX(bg_color_t->value->int32);
@@ -365,18 +2004,75 @@ static void inbox_received_callback(DictionaryIterator *iterator, void *context)
     settings.ShowDate = show_date_t->value->int32 == 1;
   }
 
+  Tuple *slope_alert_t = dict_find(iterator, MESSAGE_KEY_SlopeAlert);
+  if (slope_alert_t) {
+    settings.SlopeAlert = slope_alert_t->value->int32 == 1;
+  }
+
+  Tuple *snooze_minutes_t = dict_find(iterator, MESSAGE_KEY_SnoozeMinutes);
+  if (snooze_minutes_t) {
+    settings.SnoozeMinutes = (int)snooze_minutes_t->value->int32;
+  }
+
+  Tuple *top_slot_t = dict_find(iterator, MESSAGE_KEY_TopSlot);
+  if (top_slot_t) {
+    settings.TopSlot = prv_tuple_complication(top_slot_t);
+  }
+
+  Tuple *lower_slot_t = dict_find(iterator, MESSAGE_KEY_LowerSlot);
+  if (lower_slot_t) {
+    settings.LowerSlot = prv_tuple_complication(lower_slot_t);
+  }
+
+  Tuple *bottom_slot_t = dict_find(iterator, MESSAGE_KEY_BottomSlot);
+  if (bottom_slot_t) {
+    settings.BottomSlot = prv_tuple_complication(bottom_slot_t);
+  }
+
+  // The hash alone needs no redraw, so it is saved without re-applying
+  Tuple *settings_hash_t = dict_find(iterator, MESSAGE_KEY_SETTINGS_HASH);
+  bool settings_hash_changed = settings_hash_t &&
+                               settings_hash_t->value->uint32 != settings.SettingsHash;
+  if (settings_hash_changed) {
+    settings.SettingsHash = settings_hash_t->value->uint32;
+  }
+
+  Tuple *bt_alert_delay_t = dict_find(iterator, MESSAGE_KEY_BtAlertDelay);
+  if (bt_alert_delay_t) {
+    settings.BtAlertDelay = (int)bt_alert_delay_t->value->int32;
+    phone_link_set_alert_grace(settings.BtAlertDelay);
+  }
+
+  Tuple *language_t = dict_find(iterator, MESSAGE_KEY_Language);
+  if (language_t && language_t->type == TUPLE_CSTRING) {
+    strncpy(settings.Language, language_t->value->cstring, sizeof(settings.Language) - 1);
+    settings.Language[sizeof(settings.Language) - 1] = '\0';
+    l10n_load(settings.Language);
+    s_date_layer_yday = -1;
+    update_time();
+    complications_mark_dirty(ComplicationDate);
+  }
+
   // Save and apply if any settings were changed
-  if (bg_color_t || text_color_t || temp_unit_t || show_date_t) {
+  if (bg_color_t || text_color_t || temp_unit_t || show_date_t || slope_alert_t ||
+      snooze_minutes_t || top_slot_t || lower_slot_t || bottom_slot_t || language_t ||
+      bt_alert_delay_t) {
     prv_save_settings();
-    prv_update_display();
+    prv_apply_slots();
+    // Only a colour change needs the sparkline rebuilt and the icon re-tinted
+    if (!gcolor_equal(settings.BackgroundColor, old_background) ||
+        !gcolor_equal(settings.TextColor, old_text)) {
+      prv_update_colors();
+    } else {
+      prv_update_display();
+    }
 
-    // Refetch weather if the temperature unit changed so the display updates
-    if (temp_unit_t) {
-      DictionaryIterator *iter;
-      app_message_outbox_begin(&iter);
-      dict_write_uint8(iter, MESSAGE_KEY_REQUEST_WEATHER, 1);
-      app_message_outbox_send();
+    // Weather is stored in Celsius and localized at render time
+    if (temp_unit_t || language_t) {
+      complications_mark_dirty(ComplicationWeather);
     }
+  } else if (settings_hash_changed) {
+    prv_save_settings();
   }
 }
 
@@ -386,14 +2082,25 @@ static void inbox_dropped_callback(AppMessageResult reason, void *context) {
 
 static void outbox_failed_callback(DictionaryIterator *iterator, AppMessageResult reason, void *context) {
   APP_LOG(APP_LOG_LEVEL_ERROR, "Outbox send failed!");
+
+  #if defined(PBL_HEALTH)
+  prv_hr_log_outbox_failed();
+  #endif
+  // Requests in the failed message are kept and retried by the link
+  phone_link_outbox_failed();
 }
 
 static void outbox_sent_callback(DictionaryIterator *iterator, void *context) {
   APP_LOG(APP_LOG_LEVEL_INFO, "Outbox send success!");
+  #if defined(PBL_HEALTH)
+  prv_hr_log_outbox_sent();
+  #endif
+  // Queued requests wait for the outbox if an HR log export just took it
+  phone_link_outbox_sent();
 }
 
 // Unobstructed area handlers
-#if !defined(PBL_PLATFORM_APLITE)
+#if FEATURE_QUICK_VIEW
 static void prv_unobstructed_will_change(GRect final_unobstructed_screen_area, void *context) {
   // Hide BT icon during the transition to reduce clutter
   layer_set_hidden(bitmap_layer_get_layer(s_bt_icon_layer), true);
@@ -403,28 +2110,26 @@ static void prv_unobstructed_change(AnimationProgress progress, void *context) {
   GRect bounds = layer_get_unobstructed_bounds(s_window_layer);
 
   // Reposition time, date, and weather to fit in the available space
-  int date_height = 30;
-  int block_height = 56 + date_height;
+  int block_height = TIME_DIGITS_SIZE + DATE_LINE_HEIGHT;
   int time_y = (bounds.size.h / 2) - (block_height / 2) - 10;
-  int date_y = time_y + 56;
-  int hr_y = bounds.size.h - PBL_IF_ROUND_ELSE(60, 50);
-  int weather_y = bounds.size.h - PBL_IF_ROUND_ELSE(40, 30);
+  int date_y = time_y + TIME_DIGITS_SIZE;
 
-  GRect time_frame = layer_get_frame(text_layer_get_layer(s_time_layer));
+  GRect time_frame = layer_get_frame(s_time_layer);
   time_frame.origin.y = time_y;
-  layer_set_frame(text_layer_get_layer(s_time_layer), time_frame);
+  layer_set_frame(s_time_layer, time_frame);
 
   GRect date_frame = layer_get_frame(text_layer_get_layer(s_date_layer));
   date_frame.origin.y = date_y;
   layer_set_frame(text_layer_get_layer(s_date_layer), date_frame);
 
-  GRect hr_frame = layer_get_frame(text_layer_get_layer(s_hr_layer));
-  hr_frame.origin.y = hr_y;
-  layer_set_frame(text_layer_get_layer(s_hr_layer), hr_frame);
-
-  GRect weather_frame = layer_get_frame(text_layer_get_layer(s_weather_layer));
-  weather_frame.origin.y = weather_y;
-  layer_set_frame(text_layer_get_layer(s_weather_layer), weather_frame);
+  for (int slot = SlotLower; slot < SlotCount; slot++) {
+    GRect slot_frame = layer_get_frame(text_layer_get_layer(s_slot_layers[slot]));
+    slot_frame.origin.y = prv_slot_y(slot, bounds);
+    layer_set_frame(text_layer_get_layer(s_slot_layers[slot]), slot_frame);
+  }
+  prv_layout_hr_extras();
+  prv_layout_weather_icon();
+  prv_update_fit_widths();
 }
 
 static void prv_unobstructed_did_change(void *context) {
@@ -433,11 +2138,13 @@ static void prv_unobstructed_did_change(void *context) {
   bool obstructed = !grect_equal(&full_bounds, &bounds);
 
   // Keep BT icon hidden when obstructed, otherwise restore based on connection
+  bool connected = connection_service_peek_pebble_app_connection();
   if (obstructed) {
     layer_set_hidden(bitmap_layer_get_layer(s_bt_icon_layer), true);
+    layer_set_hidden(text_layer_get_layer(s_slot_layers[SlotTop]), false);
   } else {
-    layer_set_hidden(bitmap_layer_get_layer(s_bt_icon_layer),
-      connection_service_peek_pebble_app_connection());
+    layer_set_hidden(bitmap_layer_get_layer(s_bt_icon_layer), connected);
+    layer_set_hidden(text_layer_get_layer(s_slot_layers[SlotTop]), !connected);
   }
 }
 #endif
@@ -447,49 +2154,57 @@ static void main_window_load(Window *window) {
   GRect bounds = layer_get_bounds(s_window_layer);
 
   // Load custom fonts
-  s_time_font = fonts_load_custom_font(resource_get_handle(RESOURCE_ID_FONT_JERSEY_56));
-  s_date_font = fonts_load_custom_font(resource_get_handle(RESOURCE_ID_FONT_JERSEY_24));
+  s_date_font = fonts_load_custom_font(resource_get_handle(DATE_FONT_RESOURCE_ID));
 
   // Center the time + date block vertically
-  int date_height = 30;
-  int block_height = 56 + date_height;
+  int block_height = TIME_DIGITS_SIZE + DATE_LINE_HEIGHT;
   int time_y = (bounds.size.h / 2) - (block_height / 2) - 10;
-  int date_y = time_y + 56;
+  int date_y = time_y + TIME_DIGITS_SIZE;
 
-  // Create the time TextLayer
-  s_time_layer = text_layer_create(
-      GRect(0, time_y, bounds.size.w, 60));
-  text_layer_set_background_color(s_time_layer, GColorClear);
-  text_layer_set_text_color(s_time_layer, settings.TextColor);
-  text_layer_set_font(s_time_layer, s_time_font);
-  text_layer_set_text_alignment(s_time_layer, GTextAlignmentCenter);
+  // Create the time Layer
+  s_time_layer = layer_create(GRect(0, time_y, bounds.size.w, TIME_DIGITS_SIZE + 4));
+  layer_set_update_proc(s_time_layer, time_update_proc);
 
   // Create the date TextLayer — just below the time
   s_date_layer = text_layer_create(
-      GRect(0, date_y, bounds.size.w, 30));
+      GRect(0, date_y, bounds.size.w, DATE_LINE_HEIGHT));
   text_layer_set_background_color(s_date_layer, GColorClear);
   text_layer_set_text_color(s_date_layer, settings.TextColor);
   text_layer_set_font(s_date_layer, s_date_font);
   text_layer_set_text_alignment(s_date_layer, GTextAlignmentCenter);
 
-  int hr_y = bounds.size.h - PBL_IF_ROUND_ELSE(60, 50);
-  s_hr_layer = text_layer_create(
-      GRect(0, hr_y, bounds.size.w, 22));
-  text_layer_set_background_color(s_hr_layer, GColorClear);
-  text_layer_set_text_color(s_hr_layer, settings.TextColor);
-  text_layer_set_font(s_hr_layer, fonts_get_system_font(FONT_KEY_GOTHIC_18_BOLD));
-  text_layer_set_text_alignment(s_hr_layer, GTextAlignmentCenter);
-  text_layer_set_text(s_hr_layer, "-- BPM");
-
-  // Create weather TextLayer — aligned to the bottom of the screen
-  int weather_y = bounds.size.h - PBL_IF_ROUND_ELSE(40, 30);
-  s_weather_layer = text_layer_create(
-      GRect(0, weather_y, bounds.size.w, 25));
-  text_layer_set_background_color(s_weather_layer, GColorClear);
-  text_layer_set_text_color(s_weather_layer, settings.TextColor);
-  text_layer_set_font(s_weather_layer, fonts_get_system_font(FONT_KEY_GOTHIC_18));
-  text_layer_set_text_alignment(s_weather_layer, GTextAlignmentCenter);
-  text_layer_set_text(s_weather_layer, "Loading...");
+  // Create the complication slot TextLayers — one under the battery bar and
+  // two at the bottom of the screen. Text too wide for a slot steps down to
+  // the next font before it is abbreviated.
+  static const int s_slot_heights[SlotCount] = { 18, 22, 25 };
+  static const char *const s_slot_fonts[SlotCount][2] = {
+    { FONT_KEY_GOTHIC_14 },
+    { FONT_KEY_GOTHIC_18_BOLD, FONT_KEY_GOTHIC_14_BOLD },
+    { FONT_KEY_GOTHIC_18, FONT_KEY_GOTHIC_14 }
+  };
+  for (int slot = 0; slot < SlotCount; slot++) {
+    s_slot_layers[slot] = text_layer_create(
+        GRect(0, prv_slot_y(slot, bounds), bounds.size.w, s_slot_heights[slot]));
+    text_layer_set_background_color(s_slot_layers[slot], GColorClear);
+    text_layer_set_text_color(s_slot_layers[slot], settings.TextColor);
+    text_layer_set_font(s_slot_layers[slot], fonts_get_system_font(s_slot_fonts[slot][0]));
+    text_layer_set_text_alignment(s_slot_layers[slot], GTextAlignmentCenter);
+
+    TextFit *fit = &s_slot_fits[slot];
+    fit->font_count = 0;
+    for (int font = 0; font < (FEATURE_SMALL_SLOT_FONTS ? 2 : 1) && s_slot_fonts[slot][font];
+         font++) {
+      fit->fonts[fit->font_count++] = fonts_get_system_font(s_slot_fonts[slot][font]);
+    }
+    complications_set_fit(slot, fit);
+  }
+
+  #if FEATURE_WEATHER_ICONS
+  // Create the weather icon Layer — overlays whichever slot shows the weather
+  s_weather_icon_layer = layer_create(GRect(0, prv_slot_y(SlotBottom, bounds) + 3,
+                                            bounds.size.w, 20));
+  layer_set_update_proc(s_weather_icon_layer, weather_icon_update_proc);
+  #endif
 
   // Create battery meter Layer — visible bar near the top
   int bar_width = bounds.size.w / 2;
@@ -498,25 +2213,62 @@ static void main_window_load(Window *window) {
   s_battery_layer = layer_create(GRect(bar_x, bar_y, bar_width, 8));
   layer_set_update_proc(s_battery_layer, battery_update_proc);
 
+  #if defined(PBL_HEALTH)
+  // Create the HR zone bar — a thin strip just above the HR line. Both follow
+  // whichever slot the HR complication is placed in.
+  int hr_y = prv_slot_y(SlotLower, bounds);
+  s_zone_layer = layer_create(GRect(bar_x, hr_y - 3, bar_width, 3));
+  layer_set_update_proc(s_zone_layer, zone_update_proc);
+
+  // Create the HR sparkline — drawn beneath the HR text, one column per minute
+  s_spark_layer = layer_create(GRect((bounds.size.w - SPARK_MINUTES) / 2, hr_y + 2,
+                                     SPARK_MINUTES, SPARK_HEIGHT));
+  layer_set_update_proc(s_spark_layer, spark_update_proc);
+  s_spark_bitmap = gbitmap_create_blank(GSize(SPARK_MINUTES, SPARK_HEIGHT),
+                                        PBL_IF_COLOR_ELSE(GBitmapFormat8Bit, GBitmapFormat1Bit));
+  #endif
+
   // Create the Bluetooth icon GBitmap
   s_bt_icon_bitmap = gbitmap_create_with_resource(RESOURCE_ID_IMAGE_BT_ICON);
   int bt_y = bar_y + 12;
-  s_bt_icon_layer = bitmap_layer_create(GRect((bounds.size.w - 30) / 2, bt_y, 30, 30));
+  s_bt_icon_layer = bitmap_layer_create(GRect((bounds.size.w - BT_ICON_SIZE) / 2, bt_y,
+                                              BT_ICON_SIZE, BT_ICON_SIZE));
   bitmap_layer_set_bitmap(s_bt_icon_layer, s_bt_icon_bitmap);
   bitmap_layer_set_compositing_mode(s_bt_icon_layer, GCompOpSet);
+  bool connected = connection_service_peek_pebble_app_connection();
+  layer_set_hidden(bitmap_layer_get_layer(s_bt_icon_layer), connected);
+  layer_set_hidden(text_layer_get_layer(s_slot_layers[SlotTop]), !connected);
 
   // Add layers to the Window
-  layer_add_child(s_window_layer, text_layer_get_layer(s_time_layer));
+  layer_add_child(s_window_layer, s_time_layer);
   layer_add_child(s_window_layer, text_layer_get_layer(s_date_layer));
-  layer_add_child(s_window_layer, text_layer_get_layer(s_hr_layer));
-  layer_add_child(s_window_layer, text_layer_get_layer(s_weather_layer));
+  #if defined(PBL_HEALTH)
+  layer_add_child(s_window_layer, s_spark_layer);
+  #endif
+  for (int slot = 0; slot < SlotCount; slot++) {
+    layer_add_child(s_window_layer, text_layer_get_layer(s_slot_layers[slot]));
+  }
+  #if FEATURE_WEATHER_ICONS
+  layer_add_child(s_window_layer, s_weather_icon_layer);
+  #endif
   layer_add_child(s_window_layer, s_battery_layer);
+  #if defined(PBL_HEALTH)
+  layer_add_child(s_window_layer, s_zone_layer);
+  #endif
   layer_add_child(s_window_layer, bitmap_layer_get_layer(s_bt_icon_layer));
+  #if defined(PBL_HEALTH) && defined(PBL_BW)
+  // Added last so it runs after everything else has drawn
+  s_alert_invert_layer = layer_create(bounds);
+  layer_set_update_proc(s_alert_invert_layer, alert_invert_update_proc);
+  layer_set_hidden(s_alert_invert_layer, true);
+  layer_add_child(s_window_layer, s_alert_invert_layer);
+  #endif
 
   // Apply saved settings
-  prv_update_display();
+  prv_apply_slots();
+  prv_update_colors();
 
-  #if !defined(PBL_PLATFORM_APLITE)
+  #if FEATURE_QUICK_VIEW
   // Apply correct layout in case Quick View is already active
   prv_unobstructed_change(0, NULL);
   prv_unobstructed_did_change(NULL);
@@ -532,17 +2284,47 @@ static void main_window_load(Window *window) {
 }
 
 static void main_window_unload(Window *window) {
-  #if !defined(PBL_PLATFORM_APLITE)
+  #if FEATURE_QUICK_VIEW
   unobstructed_area_service_unsubscribe();
   #endif
 
-  text_layer_destroy(s_time_layer);
+  layer_destroy(s_time_layer);
   text_layer_destroy(s_date_layer);
-  text_layer_destroy(s_hr_layer);
-  text_layer_destroy(s_weather_layer);
-  fonts_unload_custom_font(s_time_font);
+  for (int slot = 0; slot < SlotCount; slot++) {
+    complications_place(slot, ComplicationNone, NULL);
+    text_layer_destroy(s_slot_layers[slot]);
+    s_slot_layers[slot] = NULL;
+  }
   fonts_unload_custom_font(s_date_font);
   layer_destroy(s_battery_layer);
+  #if FEATURE_WEATHER_ICONS
+  layer_destroy(s_weather_icon_layer);
+  s_weather_icon_layer = NULL;
+  if (s_weather_icon) {
+    gdraw_command_image_destroy(s_weather_icon);
+    s_weather_icon = NULL;
+  }
+  s_weather_icon_id = 0;
+  #endif
+  #if defined(PBL_HEALTH) && defined(PBL_BW)
+  layer_destroy(s_alert_invert_layer);
+  s_alert_invert_layer = NULL;
+  #endif
+  #if defined(PBL_HEALTH)
+  layer_destroy(s_zone_layer);
+  s_zone_layer = NULL;
+  layer_destroy(s_spark_layer);
+  if (s_spark_old_part) {
+    gbitmap_destroy(s_spark_old_part);
+    s_spark_old_part = NULL;
+  }
+  if (s_spark_new_part) {
+    gbitmap_destroy(s_spark_new_part);
+    s_spark_new_part = NULL;
+  }
+  gbitmap_destroy(s_spark_bitmap);
+  s_spark_bitmap = NULL;
+  #endif
   gbitmap_destroy(s_bt_icon_bitmap);
   bitmap_layer_destroy(s_bt_icon_layer);
 }
@@ -551,6 +2333,25 @@ static void init() {
   // Load settings before creating UI
   prv_load_settings();
 
+  // Open AppMessage before the UI is built so the launch handshake is not
+  // held up behind it
+  app_message_register_inbox_received(inbox_received_callback);
+  app_message_register_inbox_dropped(inbox_dropped_callback);
+  app_message_register_outbox_failed(outbox_failed_callback);
+  app_message_register_outbox_sent(outbox_sent_callback);
+  const int inbox_size = 256;
+  const int outbox_size = 256;
+  app_message_open(inbox_size, outbox_size);
+
+  prv_load_weather();
+  prv_load_sun_location();
+  #if FEATURE_SECOND_ZONE
+  prv_load_second_zone();
+  #endif
+  l10n_load(settings.Language);
+  time_sprites_load();
+  complications_init(s_complications);
+
   s_main_window = window_create();
   window_set_background_color(s_main_window, settings.BackgroundColor);
   window_set_window_handlers(s_main_window, (WindowHandlers) {
@@ -561,45 +2362,76 @@ static void init() {
 
   update_time();
 
+  // The refresh interval runs from the cached reading; with none, the
+  // handshake asks PebbleKit JS to fetch
+  s_weather_last_request = s_weather_time != 0 ? s_weather_time : time(NULL);
   tick_timer_service_subscribe(MINUTE_UNIT, tick_handler);
 
+  // Seed the power level first so the initial callback does not look like a
+  // charger being connected before the health state is loaded
+  power_update(battery_state_service_peek());
   battery_state_service_subscribe(battery_callback);
   battery_callback(battery_state_service_peek());
 
-  connection_service_subscribe((ConnectionHandlers) {
-    .pebble_app_connection_handler = bluetooth_callback
-  });
+  phone_link_init((PhoneLinkHandlers) {
+    .status = bluetooth_callback,
+    .alert = bluetooth_alert_callback,
+    .write_requests = prv_write_phone_requests
+  }, settings.BtAlertDelay);
 
   #if defined(PBL_HEALTH)
   health_service_events_subscribe(health_handler, NULL);
-  health_service_set_heart_rate_sample_period(HR_FAST_SAMPLE_PERIOD_SEC);
+  health_service_set_heart_rate_sample_period(HR_IDLE_SAMPLE_PERIOD_SEC);
+  hr_outlier_filter_init(&s_hr_filter);
+  hr_window_init(&s_hr_window, HR_ALERT_WINDOW_SEC);
+  hr_blocks_init(&s_hr_blocks);
+  prv_load_baseline();
+  prv_load_zone_totals();
+  prv_hr_log_load();
   prv_handle_heart_rate_update();
+  prv_posture_subscribe();
+  accel_tap_service_subscribe(accel_tap_handler);
+  prv_schedule_baseline_update(BASELINE_START_DELAY_MS);
   #else
   s_last_filtered_hr = 0;
   s_last_raw_hr = 0;
   s_last_window_delta = 0;
-  prv_update_hr_display();
+  s_last_short_window_delta = 0;
+  s_last_long_window_delta = 0;
+  s_last_window_slope = 0;
+  s_last_window_mean = 0;
+  complications_mark_dirty(ComplicationHeartRate);
   #endif
 
-  // Register AppMessage callbacks
-  app_message_register_inbox_received(inbox_received_callback);
-  app_message_register_inbox_dropped(inbox_dropped_callback);
-  app_message_register_outbox_failed(outbox_failed_callback);
-  app_message_register_outbox_sent(outbox_sent_callback);
-
-  // Open AppMessage
-  const int inbox_size = 256;
-  const int outbox_size = 256;
-  app_message_open(inbox_size, outbox_size);
+  // Announce what is cached; PebbleKit JS answers with only what is missing
+  phone_link_request(PhoneRequestHello);
 }
 
 static void deinit() {
+  complications_deinit();
+  phone_link_deinit();
+
   if (s_hr_alert_timer) {
     app_timer_cancel(s_hr_alert_timer);
     s_hr_alert_timer = NULL;
   }
 
   #if defined(PBL_HEALTH)
+  if (s_stand_timer) {
+    app_timer_cancel(s_stand_timer);
+    s_stand_timer = NULL;
+  }
+  if (s_baseline_timer) {
+    app_timer_cancel(s_baseline_timer);
+    s_baseline_timer = NULL;
+  }
+  free(s_baseline_minutes);
+  s_baseline_minutes = NULL;
+  prv_posture_unsubscribe();
+  accel_tap_service_unsubscribe();
+  persist_write_data(ZONES_KEY, &s_zone_totals, sizeof(s_zone_totals));
+  prv_close_alert_event();
+  prv_hr_log_flush();
   health_service_set_heart_rate_sample_period(0);
   health_service_events_unsubscribe();
   #endif
@@ -0,0 +1,138 @@
+#include "phone_link.h"
+
+static PhoneLinkHandlers s_handlers;
+static uint32_t s_alert_grace_sec;
+static bool s_connected;
+static uint32_t s_pending;
+// Bits of the message in the outbox; AppMessage has one outbox, so the next
+// sent or failed callback is for it
+static uint32_t s_in_flight;
+static int s_failures;
+static AppTimer *s_alert_timer;
+static AppTimer *s_replay_timer;
+
+static void prv_cancel(AppTimer **timer) {
+  if (*timer) {
+    app_timer_cancel(*timer);
+    *timer = NULL;
+  }
+}
+
+static void alert_timer_callback(void *context) {
+  s_alert_timer = NULL;
+  if (!s_connected && s_handlers.alert) {
+    s_handlers.alert();
+  }
+}
+
+static void replay_timer_callback(void *context) {
+  s_replay_timer = NULL;
+  if (s_pending) {
+    phone_link_request(0);
+  }
+}
+
+static void prv_schedule_replay(uint32_t delay_ms) {
+  if (!s_replay_timer) {
+    s_replay_timer = app_timer_register(delay_ms, replay_timer_callback, NULL);
+  }
+}
+
+static void prv_connection_handler(bool connected) {
+  if (connected == s_connected) {
+    return;
+  }
+  s_connected = connected;
+
+  if (connected) {
+    // A drop shorter than the grace period never alerts
+    prv_cancel(&s_alert_timer);
+    s_failures = 0;
+    if (s_pending) {
+      prv_schedule_replay(PHONE_LINK_REPLAY_DELAY_MS);
+    }
+  } else {
+    prv_cancel(&s_replay_timer);
+    if (!s_alert_timer) {
+      s_alert_timer = app_timer_register(s_alert_grace_sec * 1000, alert_timer_callback, NULL);
+    }
+  }
+
+  if (s_handlers.status) {
+    s_handlers.status(connected);
+  }
+}
+
+void phone_link_init(PhoneLinkHandlers handlers, uint32_t alert_grace_sec) {
+  s_handlers = handlers;
+  s_alert_grace_sec = alert_grace_sec;
+  s_connected = connection_service_peek_pebble_app_connection();
+  s_pending = 0;
+  s_in_flight = 0;
+  s_failures = 0;
+  connection_service_subscribe((ConnectionHandlers) {
+    .pebble_app_connection_handler = prv_connection_handler
+  });
+}
+
+void phone_link_deinit(void) {
+  connection_service_unsubscribe();
+  prv_cancel(&s_alert_timer);
+  prv_cancel(&s_replay_timer);
+}
+
+void phone_link_set_alert_grace(uint32_t alert_grace_sec) {
+  s_alert_grace_sec = alert_grace_sec;
+}
+
+bool phone_link_connected(void) {
+  return s_connected;
+}
+
+bool phone_link_request(uint32_t requests) {
+  // Anything still waiting rides along with this message
+  s_pending |= requests;
+  if (!s_connected || s_replay_timer || s_pending == 0) {
+    // Unreachable, or a replay is about to go out: fold into that
+    return false;
+  }
+
+  // A busy outbox (e.g. an HR log export) keeps the bits pending until the
+  // current message completes
+  DictionaryIterator *iter;
+  if (app_message_outbox_begin(&iter) != APP_MSG_OK) {
+    return false;
+  }
+  s_handlers.write_requests(iter, s_pending);
+  if (app_message_outbox_send() != APP_MSG_OK) {
+    return false;
+  }
+  s_in_flight = s_pending;
+  s_pending = 0;
+  return true;
+}
+
+void phone_link_outbox_sent(void) {
+  if (s_in_flight) {
+    s_in_flight = 0;
+    s_failures = 0;
+  }
+  if (s_pending) {
+    phone_link_request(0);
+  }
+}
+
+void phone_link_outbox_failed(void) {
+  if (!s_in_flight) {
+    return;
+  }
+  s_pending |= s_in_flight;
+  s_in_flight = 0;
+
+  // Typically PebbleKit JS is not running yet; back off, and after a few
+  // tries leave the bits for the next request or reconnect
+  if (s_connected && s_failures < PHONE_LINK_MAX_RETRIES) {
+    prv_schedule_replay(PHONE_LINK_RETRY_MS << s_failures);
+    s_failures++;
+  }
+}
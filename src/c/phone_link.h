@@ -0,0 +1,58 @@
+#pragma once
+
+#include <pebble.h>
+
+// Waits this long after a reconnect before replaying, so a flapping link
+// produces one refresh and PebbleKit JS has time to come back up
+#define PHONE_LINK_REPLAY_DELAY_MS 3000
+// A failed send is retried after this, doubling each time, at most
+// PHONE_LINK_MAX_RETRIES times in a row
+#define PHONE_LINK_RETRY_MS 1000
+#define PHONE_LINK_MAX_RETRIES 3
+
+// Requests the watch sends to PebbleKit JS, as a bit set
+typedef enum PhoneRequest {
+  PhoneRequestWeather = 1 << 0,
+  PhoneRequestSecondZone = 1 << 1,
+  // Launch handshake: what the watch already has, so the phone sends only
+  // what is missing
+  PhoneRequestHello = 1 << 2
+} PhoneRequest;
+
+typedef struct PhoneLinkHandlers {
+  // Called on every connection change, for status UI
+  void (*status)(bool connected);
+  // Called once the link has stayed down for the alert grace period
+  void (*alert)(void);
+  // Writes the keys for a set of PhoneRequest bits into one message
+  void (*write_requests)(DictionaryIterator *iter, uint32_t requests);
+} PhoneLinkHandlers;
+
+/**
+ * Subscribes to the phone app connection. Requests made while it is down,
+ * while the outbox is busy or whose send failed are recorded and go out
+ * together in the next message.
+ */
+void phone_link_init(PhoneLinkHandlers handlers, uint32_t alert_grace_sec);
+
+void phone_link_deinit(void);
+
+void phone_link_set_alert_grace(uint32_t alert_grace_sec);
+
+bool phone_link_connected(void);
+
+/**
+ * Sends the requests, with any still pending, now if the phone is reachable
+ * and the outbox is free. Otherwise they stay queued for the next reconnect
+ * or outbox completion. Returns true when sent.
+ */
+bool phone_link_request(uint32_t requests);
+
+/**
+ * Call from the AppMessage outbox sent and failed handlers. They settle the
+ * message phone_link sent, if it was the one in the outbox, and send what is
+ * pending.
+ */
+void phone_link_outbox_sent(void);
+
+void phone_link_outbox_failed(void);
@@ -0,0 +1,38 @@
+#include "power.h"
+
+// Percent of the base period, indexed by PowerLevel
+static const uint16_t s_interval_percent[] = { 50, 100, 200, 400 };
+
+static PowerLevel s_level = PowerLevelNormal;
+
+static PowerLevel prv_level_for(BatteryChargeState state) {
+  if (state.is_plugged) {
+    return PowerLevelPlugged;
+  }
+  if (state.charge_percent <= POWER_CRITICAL_PERCENT) {
+    return PowerLevelCritical;
+  }
+  if (state.charge_percent <= POWER_LOW_PERCENT) {
+    return PowerLevelLow;
+  }
+  return PowerLevelNormal;
+}
+
+bool power_update(BatteryChargeState state) {
+  PowerLevel level = prv_level_for(state);
+  bool changed = level != s_level;
+  s_level = level;
+  return changed;
+}
+
+PowerLevel power_level(void) {
+  return s_level;
+}
+
+uint32_t power_interval(uint32_t base) {
+  return (base * s_interval_percent[s_level]) / 100;
+}
+
+bool power_allows_heavy_work(void) {
+  return s_level != PowerLevelCritical;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <pebble.h>
+
+// Charge thresholds shared with the battery bar's red and yellow colours
+#define POWER_CRITICAL_PERCENT 20
+#define POWER_LOW_PERCENT 40
+
+typedef enum PowerLevel {
+  PowerLevelPlugged,
+  PowerLevelNormal,
+  PowerLevelLow,
+  PowerLevelCritical
+} PowerLevel;
+
+/**
+ * Records the latest battery state. Returns true when the power level
+ * changed, so callers can start work that was waiting for a charger.
+ */
+bool power_update(BatteryChargeState state);
+
+PowerLevel power_level(void);
+
+/**
+ * Scales the period of deferrable background work to the power level: half
+ * on the charger, unchanged above the yellow threshold, then 2x and 4x as the
+ * charge falls through yellow and red.
+ */
+uint32_t power_interval(uint32_t base);
+
+/**
+ * Whether heavy optional work (history scans) may start now. It is held back
+ * on a red battery until the watch is plugged in or recovers.
+ */
+bool power_allows_heavy_work(void);
@@ -0,0 +1,98 @@
+#include "solar.h"
+
+// Degrees and radians expressed in TRIG_MAX_ANGLE units
+#define SOLAR_DEG_E2_TO_TRIG(deg_e2) (((int64_t)(deg_e2) * TRIG_MAX_ANGLE) / 36000)
+#define SOLAR_RAD_E6_TO_TRIG(rad_e6) (((int64_t)(rad_e6) * TRIG_MAX_ANGLE) / 6283185)
+
+// Official zenith for sunrise/sunset including refraction, 90.833 degrees
+#define SOLAR_ZENITH_DEG_E3 90833
+
+/**
+ * Sums coefficient * cos/sin(k * gamma) terms, with coefficients scaled by
+ * 1e6, and returns the result scaled by 1e6.
+ */
+static int32_t prv_fourier_e6(int32_t gamma, int32_t c0, const int32_t *cos_terms,
+                              const int32_t *sin_terms, int terms) {
+  int64_t sum = (int64_t)c0 * TRIG_MAX_RATIO;
+  for (int k = 1; k <= terms; k++) {
+    sum += (int64_t)cos_terms[k - 1] * cos_lookup(k * gamma);
+    sum += (int64_t)sin_terms[k - 1] * sin_lookup(k * gamma);
+  }
+  return (int32_t)(sum / TRIG_MAX_RATIO);
+}
+
+/**
+ * Inverse cosine by bisection over [0, pi], where cos_lookup is decreasing.
+ */
+static int32_t prv_acos_lookup(int32_t ratio) {
+  int32_t low = 0;
+  int32_t high = TRIG_MAX_ANGLE / 2;
+  while (high - low > 1) {
+    int32_t mid = (low + high) / 2;
+    if (cos_lookup(mid) > ratio) {
+      low = mid;
+    } else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+SolarDay solar_compute(int32_t lat_e2, int32_t lon_e2, int yday,
+                       int32_t *sunrise_utc_sec, int32_t *sunset_utc_sec) {
+  static const int32_t s_decl_cos[] = { -399912, -6758, -2697 };
+  static const int32_t s_decl_sin[] = { 70257, 907, 1480 };
+  static const int32_t s_eqt_cos[] = { 1868, -14615 };
+  static const int32_t s_eqt_sin[] = { -32077, -40849 };
+
+  // Fractional year
+  int32_t gamma = (int32_t)(((int64_t)yday * TRIG_MAX_ANGLE) / 365);
+
+  int32_t decl_e6 = prv_fourier_e6(gamma, 6918, s_decl_cos, s_decl_sin, 3);
+  int32_t decl = (int32_t)SOLAR_RAD_E6_TO_TRIG(decl_e6);
+
+  // Equation of time: 229.18 min * 60 s * series
+  int32_t eqt_e6 = prv_fourier_e6(gamma, 75, s_eqt_cos, s_eqt_sin, 2);
+  int32_t eqt_sec = (int32_t)(((int64_t)eqt_e6 * 137508) / 10000000);
+
+  int32_t lat = (int32_t)SOLAR_DEG_E2_TO_TRIG(lat_e2);
+  int32_t zenith = (int32_t)(((int64_t)SOLAR_ZENITH_DEG_E3 * TRIG_MAX_ANGLE) / 360000);
+
+  // cos(ha) = (cos(zenith) - sin(lat) sin(decl)) / (cos(lat) cos(decl))
+  int64_t numerator = ((int64_t)cos_lookup(zenith) * TRIG_MAX_RATIO) -
+                      ((int64_t)sin_lookup(lat) * sin_lookup(decl));
+  int64_t denominator = (int64_t)cos_lookup(lat) * cos_lookup(decl);
+  if (denominator == 0) {
+    // At a pole the sun's altitude only depends on the declination
+    return (lat_e2 > 0) == (decl > 0) ? SolarDayPolarDay : SolarDayPolarNight;
+  }
+  int64_t cos_ha = (numerator * TRIG_MAX_RATIO) / denominator;
+  if (cos_ha > TRIG_MAX_RATIO) {
+    return SolarDayPolarNight;
+  }
+  if (cos_ha < -TRIG_MAX_RATIO) {
+    return SolarDayPolarDay;
+  }
+
+  int32_t ha = prv_acos_lookup((int32_t)cos_ha);
+
+  // 240 seconds of time per degree of longitude or hour angle
+  int32_t ha_sec = (int32_t)(((int64_t)ha * 360 * 240) / TRIG_MAX_ANGLE);
+  int32_t lon_sec = (lon_e2 * 240) / 100;
+  int32_t noon_sec = 43200 - lon_sec - eqt_sec;
+
+  *sunrise_utc_sec = noon_sec - ha_sec;
+  *sunset_utc_sec = noon_sec + ha_sec;
+  return SolarDayNormal;
+}
+
+time_t solar_utc_midnight(int year, int month, int day) {
+  // Days from civil, proleptic Gregorian
+  year -= month <= 2;
+  int era = (year >= 0 ? year : year - 399) / 400;
+  int yoe = year - (era * 400);
+  int doy = ((153 * (month + (month > 2 ? -3 : 9))) + 2) / 5 + day - 1;
+  int doe = (yoe * 365) + (yoe / 4) - (yoe / 100) + doy;
+  int32_t days = (era * 146097) + doe - 719468;
+  return (time_t)days * SECONDS_PER_DAY;
+}
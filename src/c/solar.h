@@ -0,0 +1,24 @@
+#pragma once
+
+#include <pebble.h>
+
+typedef enum SolarDay {
+  SolarDayNormal,
+  SolarDayPolarDay,
+  SolarDayPolarNight
+} SolarDay;
+
+/**
+ * Computes sunrise and sunset for a day with the NOAA approximation, in
+ * integer arithmetic on the SDK trig lookup tables. Coordinates are in
+ * hundredths of a degree (east and north positive), yday is 0-based and the
+ * results are seconds after UTC midnight of that date, only written for
+ * SolarDayNormal.
+ */
+SolarDay solar_compute(int32_t lat_e2, int32_t lon_e2, int yday,
+                       int32_t *sunrise_utc_sec, int32_t *sunset_utc_sec);
+
+/**
+ * Returns the Unix time of UTC midnight on the given civil date.
+ */
+time_t solar_utc_midnight(int year, int month, int day);
@@ -0,0 +1,106 @@
+#include "text_fit.h"
+
+// Wide enough that a single line never wraps while measuring
+#define TEXT_FIT_MEASURE_WIDTH 1000
+// Words up to this many characters, or with digits, are kept whole
+#define TEXT_FIT_ABBREV_MIN 5
+#define TEXT_FIT_ABBREV_KEEP 3
+
+typedef struct MeasureEntry {
+  uint32_t hash;
+  GFont font;
+  int16_t width;
+} MeasureEntry;
+
+// Keyed by text and font only: the single-line width does not depend on the
+// box, so a TextFit width change re-uses the entries.
+static MeasureEntry s_cache[TEXT_FIT_CACHE_SIZE];
+static int s_cache_next;
+
+// FNV-1a
+static uint32_t prv_hash(const char *text) {
+  uint32_t hash = 2166136261u;
+  for (; *text; text++) {
+    hash = (hash ^ (uint8_t)*text) * 16777619u;
+  }
+  return hash;
+}
+
+static int prv_measure(const char *text, GFont font) {
+  uint32_t hash = prv_hash(text);
+  for (int index = 0; index < TEXT_FIT_CACHE_SIZE; index++) {
+    if (s_cache[index].font == font && s_cache[index].hash == hash) {
+      return s_cache[index].width;
+    }
+  }
+
+  GSize size = graphics_text_layout_get_content_size(
+      text, font, GRect(0, 0, TEXT_FIT_MEASURE_WIDTH, 100),
+      GTextOverflowModeFill, GTextAlignmentLeft);
+  s_cache[s_cache_next] = (MeasureEntry) { .hash = hash, .font = font, .width = size.w };
+  s_cache_next = (s_cache_next + 1) % TEXT_FIT_CACHE_SIZE;
+  return size.w;
+}
+
+static bool prv_is_continuation(char byte) {
+  return ((uint8_t)byte & 0xC0) == 0x80;
+}
+
+/**
+ * Shortens the last word still worth abbreviating to its first few
+ * characters and a period. Returns false when there is none.
+ */
+static bool prv_abbreviate_last(char *text) {
+  char *end = text + strlen(text);
+  while (end > text) {
+    // Walk back over one word, counting UTF-8 characters
+    char *word_end = end;
+    int characters = 0;
+    bool digits = false;
+    while (end > text && end[-1] != ' ') {
+      end--;
+      if (!prv_is_continuation(*end)) {
+        characters++;
+      }
+      digits |= *end >= '0' && *end <= '9';
+    }
+    char *word = end;
+
+    if (characters >= TEXT_FIT_ABBREV_MIN && !digits && word_end[-1] != '.') {
+      char *cut = word;
+      for (int kept = 0; kept < TEXT_FIT_ABBREV_KEEP; kept++) {
+        do {
+          cut++;
+        } while (prv_is_continuation(*cut));
+      }
+      *cut++ = '.';
+      memmove(cut, word_end, strlen(word_end) + 1);
+      return true;
+    }
+
+    while (end > text && end[-1] == ' ') {
+      end--;
+    }
+  }
+  return false;
+}
+
+int text_fit(const TextFit *fit, char *text) {
+  if (fit->font_count == 0) {
+    return 0;
+  }
+
+  for (int index = 0; index < fit->font_count; index++) {
+    if (prv_measure(text, fit->fonts[index]) <= fit->width) {
+      return index;
+    }
+  }
+
+  int smallest = fit->font_count - 1;
+  while (prv_abbreviate_last(text)) {
+    if (prv_measure(text, fit->fonts[smallest]) <= fit->width) {
+      break;
+    }
+  }
+  return smallest;
+}
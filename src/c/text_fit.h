@@ -0,0 +1,24 @@
+#pragma once
+
+#include <pebble.h>
+#include "features.auto.h"
+
+// TEXT_FIT_CACHE_SIZE, the number of measured widths kept across renders and
+// shared by every TextFit, comes from the platform's feature profile.
+#define TEXT_FIT_MAX_FONTS 3
+
+typedef struct TextFit {
+  // Candidate fonts, largest first
+  GFont fonts[TEXT_FIT_MAX_FONTS];
+  uint8_t font_count;
+  // Width the text must fit on one line
+  int16_t width;
+} TextFit;
+
+/**
+ * Picks the largest font the text fits in on a single line. If none fits,
+ * words are abbreviated in place from the end ("Drizzle" to "Dri.") at the
+ * smallest font until it does or nothing is left to shorten. Returns the
+ * index of the chosen font.
+ */
+int text_fit(const TextFit *fit, char *text);
@@ -0,0 +1,68 @@
+#include "time_format.h"
+
+static const char *const s_day_names[7] = {
+  "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"
+};
+
+static const char *const s_month_names[12] = {
+  "Jan", "Feb", "Mar", "Apr", "May", "Jun",
+  "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"
+};
+
+static char *prv_put_two_digits(char *out, int value) {
+  *out++ = (char)('0' + (value / 10));
+  *out++ = (char)('0' + (value % 10));
+  return out;
+}
+
+static char *prv_put_name(char *out, const char *name) {
+  for (int index = 0; index < TIME_FORMAT_NAME_MAX && name[index]; index++) {
+    *out++ = name[index];
+  }
+  return out;
+}
+
+size_t time_format_clock(char *buffer, size_t size, int hour, int minute, bool is_24h) {
+  if (size < TIME_FORMAT_CLOCK_SIZE) {
+    if (size > 0) {
+      buffer[0] = '\0';
+    }
+    return 0;
+  }
+
+  char *out = buffer;
+  if (!is_24h) {
+    hour %= 12;
+    if (hour == 0) {
+      hour = 12;
+    }
+  }
+  if (is_24h || hour >= 10) {
+    out = prv_put_two_digits(out, hour);
+  } else {
+    *out++ = (char)('0' + hour);
+  }
+  *out++ = ':';
+  out = prv_put_two_digits(out, minute);
+  *out = '\0';
+  return (size_t)(out - buffer);
+}
+
+size_t time_format_date(char *buffer, size_t size, const struct tm *tm,
+                        const char *const *day_names, const char *const *month_names) {
+  if (size < TIME_FORMAT_DATE_SIZE) {
+    if (size > 0) {
+      buffer[0] = '\0';
+    }
+    return 0;
+  }
+
+  char *out = buffer;
+  out = prv_put_name(out, (day_names ? day_names : s_day_names)[tm->tm_wday % 7]);
+  *out++ = ' ';
+  out = prv_put_name(out, (month_names ? month_names : s_month_names)[tm->tm_mon % 12]);
+  *out++ = ' ';
+  out = prv_put_two_digits(out, tm->tm_mday);
+  *out = '\0';
+  return (size_t)(out - buffer);
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+// Allocation-free clock and date formatting from struct tm fields, replacing
+// strftime on the per-minute path. No Pebble SDK dependency, so it also
+// builds on a desktop host.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+
+// "HH:MM" plus terminator
+#define TIME_FORMAT_CLOCK_SIZE 6
+// Longest UTF-8 day and month name accepted by time_format_date
+#define TIME_FORMAT_NAME_MAX 8
+// "<day> <month> DD" plus terminator
+#define TIME_FORMAT_DATE_SIZE ((2 * TIME_FORMAT_NAME_MAX) + 5)
+
+/**
+ * Writes "HH:MM" in 24-hour mode, or "H:MM" in 12-hour mode with no leading
+ * zero. Returns the length written, or 0 (and an empty string) when size is
+ * below TIME_FORMAT_CLOCK_SIZE.
+ */
+size_t time_format_clock(char *buffer, size_t size, int hour, int minute, bool is_24h);
+
+/**
+ * Writes the date as "<day> <month> DD", the layout of strftime's "%a %b %d".
+ * day_names (indexed by tm_wday) and month_names (by tm_mon) may be NULL for
+ * the built-in English names; longer names are cut at TIME_FORMAT_NAME_MAX
+ * bytes. Returns the length written, or 0 when size is below
+ * TIME_FORMAT_DATE_SIZE.
+ */
+size_t time_format_date(char *buffer, size_t size, const struct tm *tm,
+                        const char *const *day_names, const char *const *month_names);
@@ -0,0 +1,182 @@
+#include "time_sprites.h"
+
+#define TIME_SPRITES_VERSION 1
+#define TIME_SPRITES_HEADER_SIZE 8
+#define TIME_SPRITES_ENTRY_SIZE 6
+
+typedef struct Glyph {
+  char code;
+  uint8_t width;
+  uint16_t x;
+  int8_t bearing;
+  uint8_t advance;
+} Glyph;
+
+static uint8_t s_data[TIME_SPRITES_MAX_BYTES];
+static Glyph s_glyphs[TIME_SPRITES_MAX_GLYPHS];
+static int s_glyph_count;
+static int s_height;
+static int s_top;
+static int s_row_bytes;
+static const uint8_t *s_rows;
+
+static uint16_t prv_read_u16(const uint8_t *bytes) {
+  return (uint16_t)(bytes[0] | (bytes[1] << 8));
+}
+
+bool time_sprites_load(void) {
+  s_glyph_count = 0;
+
+  ResHandle handle = resource_get_handle(RESOURCE_ID_TIME_DIGITS);
+  size_t size = resource_size(handle);
+  if (size < TIME_SPRITES_HEADER_SIZE || size > sizeof(s_data) ||
+      resource_load(handle, s_data, size) != size || s_data[0] != TIME_SPRITES_VERSION ||
+      s_data[1] > TIME_SPRITES_MAX_GLYPHS) {
+    return false;
+  }
+
+  int glyph_count = s_data[1];
+  s_height = s_data[2];
+  s_top = s_data[3];
+  s_row_bytes = prv_read_u16(&s_data[4]);
+  size_t rows_offset = TIME_SPRITES_HEADER_SIZE + (glyph_count * TIME_SPRITES_ENTRY_SIZE);
+  if (rows_offset + ((size_t)s_height * s_row_bytes) > size) {
+    return false;
+  }
+
+  for (int index = 0; index < glyph_count; index++) {
+    const uint8_t *entry = &s_data[TIME_SPRITES_HEADER_SIZE + (index * TIME_SPRITES_ENTRY_SIZE)];
+    s_glyphs[index] = (Glyph) {
+      .code = (char)entry[0],
+      .width = entry[1],
+      .x = prv_read_u16(&entry[2]),
+      .bearing = (int8_t)entry[4],
+      .advance = entry[5],
+    };
+  }
+  s_rows = &s_data[rows_offset];
+  s_glyph_count = glyph_count;
+  return true;
+}
+
+static const Glyph *prv_glyph(char code) {
+  // Digits are packed in order, so they index directly
+  int index = code - '0';
+  if (index >= 0 && index < s_glyph_count && s_glyphs[index].code == code) {
+    return &s_glyphs[index];
+  }
+  for (index = 0; index < s_glyph_count; index++) {
+    if (s_glyphs[index].code == code) {
+      return &s_glyphs[index];
+    }
+  }
+  return NULL;
+}
+
+int time_sprites_width(const char *text) {
+  int width = 0;
+  for (; *text; text++) {
+    const Glyph *glyph = prv_glyph(*text);
+    if (glyph) {
+      width += glyph->advance;
+    }
+  }
+  return width;
+}
+
+static bool prv_ink(const uint8_t *row, int x) {
+  return (row[x / 8] >> (x % 8)) & 1;
+}
+
+/**
+ * Copies one glyph into the frame buffer, clipped to each row's visible span
+ * so it also works on the circular Chalk buffer.
+ */
+static void prv_blit(GBitmap *frame, const Glyph *glyph, int left, int top, GColor color) {
+  GBitmapFormat format = gbitmap_get_format(frame);
+  GRect bounds = gbitmap_get_bounds(frame);
+  bool ink_on = !gcolor_equal(color, GColorBlack);
+
+  for (int row = 0; row < s_height; row++) {
+    int y = top + row;
+    if (y < bounds.origin.y || y >= bounds.origin.y + bounds.size.h) {
+      continue;
+    }
+    const uint8_t *source = s_rows + (row * s_row_bytes);
+
+    #if defined(PBL_ROUND)
+    GBitmapDataRowInfo info = gbitmap_get_data_row_info(frame, y);
+    uint8_t *line = info.data;
+    int min_x = info.min_x;
+    int max_x = info.max_x;
+    #else
+    uint8_t *line = gbitmap_get_data(frame) + (y * gbitmap_get_bytes_per_row(frame));
+    int min_x = bounds.origin.x;
+    int max_x = bounds.origin.x + bounds.size.w - 1;
+    #endif
+
+    for (int column = 0; column < glyph->width; column++) {
+      int x = left + column;
+      if (x < min_x || x > max_x || !prv_ink(source, glyph->x + column)) {
+        continue;
+      }
+      if (format == GBitmapFormat1Bit) {
+        if (ink_on) {
+          line[x / 8] |= 1 << (x % 8);
+        } else {
+          line[x / 8] &= ~(1 << (x % 8));
+        }
+      } else {
+        line[x] = color.argb;
+      }
+    }
+  }
+}
+
+// Slow path: one 1-pixel-high rectangle per run of inked pixels
+static void prv_fill_runs(GContext *ctx, const Glyph *glyph, int left, int top) {
+  for (int row = 0; row < s_height; row++) {
+    const uint8_t *source = s_rows + (row * s_row_bytes);
+    int column = 0;
+    while (column < glyph->width) {
+      if (!prv_ink(source, glyph->x + column)) {
+        column++;
+        continue;
+      }
+      int start = column;
+      while (column < glyph->width && prv_ink(source, glyph->x + column)) {
+        column++;
+      }
+      graphics_fill_rect(ctx, GRect(left + start, top + row, column - start, 1), 0, GCornerNone);
+    }
+  }
+}
+
+void time_sprites_draw(GContext *ctx, Layer *layer, const char *text, GPoint origin,
+                       GColor color) {
+  GBitmap *frame = graphics_capture_frame_buffer(ctx);
+  if (!frame) {
+    graphics_context_set_fill_color(ctx, color);
+  }
+
+  // The frame buffer is in screen coordinates
+  GPoint offset = frame ? layer_get_frame(layer).origin : GPointZero;
+  int pen = origin.x + offset.x;
+  int top = origin.y + offset.y + s_top;
+  for (; *text; text++) {
+    const Glyph *glyph = prv_glyph(*text);
+    if (!glyph) {
+      continue;
+    }
+    if (frame) {
+      prv_blit(frame, glyph, pen + glyph->bearing, top, color);
+    } else {
+      prv_fill_runs(ctx, glyph, pen + glyph->bearing, top);
+    }
+    pen += glyph->advance;
+  }
+
+  if (frame) {
+    graphics_release_frame_buffer(ctx, frame);
+  }
+}
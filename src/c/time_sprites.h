@@ -0,0 +1,29 @@
+#pragma once
+
+#include <pebble.h>
+// TIME_SPRITES_MAX_BYTES, the platform's largest TIME_DIGITS resource,
+// checked by tools/make_digit_atlas.py
+#include "features.auto.h"
+
+#define TIME_SPRITES_MAX_GLYPHS 11
+
+/**
+ * Loads the pre-rasterised digit atlas into a static buffer with one
+ * resource read. Returns false if the resource is malformed.
+ */
+bool time_sprites_load(void);
+
+/**
+ * Advance width of a string of digits and colons. Other characters are
+ * skipped.
+ */
+int time_sprites_width(const char *text);
+
+/**
+ * Draws the text from a layer's update proc with its line top at origin, in
+ * layer coordinates, by writing the glyph bits directly into the frame
+ * buffer. The layer must be a direct child of the window's root layer. Falls
+ * back to filling pixel runs if the frame buffer cannot be captured.
+ */
+void time_sprites_draw(GContext *ctx, Layer *layer, const char *text, GPoint origin,
+                       GColor color);
@@ -41,11 +41,137 @@ module.exports = [
         "label": "Use Fahrenheit",
         "defaultValue": false
       },
+      {
+        "type": "select",
+        "messageKey": "Language",
+        "label": "Language",
+        "description": "Used for the date and weather conditions.",
+        "defaultValue": "en",
+        "options": [
+          { "label": "English", "value": "en" },
+          { "label": "Deutsch", "value": "de" },
+          { "label": "Español", "value": "es" },
+          { "label": "Français", "value": "fr" },
+          { "label": "Italiano", "value": "it" }
+        ]
+      },
       {
         "type": "toggle",
         "messageKey": "ShowDate",
         "label": "Show Date",
         "defaultValue": true
+      },
+      {
+        "type": "toggle",
+        "messageKey": "SlopeAlert",
+        "label": "Alert on Rising Heart Rate Trend",
+        "description": "Also alert when heart rate climbs by 20 BPM/min or more.",
+        "defaultValue": false
+      },
+      {
+        "type": "slider",
+        "messageKey": "SnoozeMinutes",
+        "label": "Snooze Length (minutes)",
+        "description": "Flick your wrist to dismiss an alert and silence new ones for this long.",
+        "defaultValue": 30,
+        "min": 5,
+        "max": 120,
+        "step": 5
+      },
+      {
+        "type": "slider",
+        "messageKey": "BtAlertDelay",
+        "label": "Disconnect Alert Delay (seconds)",
+        "description": "Vibrate only if the phone stays disconnected this long. Short drops are ignored.",
+        "defaultValue": 15,
+        "min": 0,
+        "max": 120,
+        "step": 5
+      }
+    ]
+  },
+  {
+    "type": "section",
+    "items": [
+      {
+        "type": "heading",
+        "defaultValue": "Layout"
+      },
+      {
+        "type": "text",
+        "defaultValue": "Choose what each slot shows. Hidden items cost nothing to keep up to date."
+      },
+      {
+        "type": "select",
+        "messageKey": "TopSlot",
+        "label": "Top",
+        "defaultValue": "3",
+        "options": [
+          { "label": "Nothing", "value": "0" },
+          { "label": "Heart Rate", "value": "1" },
+          { "label": "Weather", "value": "2" },
+          { "label": "Sunrise & Sunset", "value": "3" },
+          { "label": "Date", "value": "4" },
+          { "label": "Battery", "value": "5" },
+          { "label": "Steps & Activity", "value": "6" },
+          { "label": "Second Time Zone", "value": "7" }
+        ]
+      },
+      {
+        "type": "select",
+        "messageKey": "LowerSlot",
+        "label": "Lower",
+        "defaultValue": "1",
+        "options": [
+          { "label": "Nothing", "value": "0" },
+          { "label": "Heart Rate", "value": "1" },
+          { "label": "Weather", "value": "2" },
+          { "label": "Sunrise & Sunset", "value": "3" },
+          { "label": "Date", "value": "4" },
+          { "label": "Battery", "value": "5" },
+          { "label": "Steps & Activity", "value": "6" },
+          { "label": "Second Time Zone", "value": "7" }
+        ]
+      },
+      {
+        "type": "select",
+        "messageKey": "BottomSlot",
+        "label": "Bottom",
+        "defaultValue": "2",
+        "options": [
+          { "label": "Nothing", "value": "0" },
+          { "label": "Heart Rate", "value": "1" },
+          { "label": "Weather", "value": "2" },
+          { "label": "Sunrise & Sunset", "value": "3" },
+          { "label": "Date", "value": "4" },
+          { "label": "Battery", "value": "5" },
+          { "label": "Steps & Activity", "value": "6" },
+          { "label": "Second Time Zone", "value": "7" }
+        ]
+      },
+      {
+        "type": "input",
+        "messageKey": "SecondZone",
+        "label": "Second Time Zone",
+        "description": "IANA zone name, e.g. America/New_York. Place \"Second Time Zone\" in a slot to show it.",
+        "defaultValue": "",
+        "attributes": {
+          "placeholder": "America/New_York"
+        }
+      }
+    ]
+  },
+  {
+    "type": "section",
+    "items": [
+      {
+        "type": "heading",
+        "defaultValue": "Recent HR Events"
+      },
+      {
+        "type": "text",
+        "id": "HrEventLog",
+        "defaultValue": "No HR events recorded yet."
       }
     ]
   },
@@ -1,5 +1,6 @@
 // Import the Clay package
 var Clay = require('@rebble/clay');
+var messageKeys = require('message_keys');
 // Load our Clay configuration file
 var clayConfig = require('./config');
 // Initialize Clay
@@ -15,24 +16,6 @@ var xhrRequest = function (url, type, callback) {
   xhr.send();
 };
 
-// Convert Open-Meteo weather code to human-readable condition
-function weatherCodeToCondition(code) {
-  if (code === 0) return 'Clear';
-  if (code <= 3) return 'Cloudy';
-  if (code <= 48) return 'Fog';
-  if (code <= 55) return 'Drizzle';
-  if (code <= 57) return 'Fz. Drizzle';
-  if (code <= 65) return 'Rain';
-  if (code <= 67) return 'Fz. Rain';
-  if (code <= 75) return 'Snow';
-  if (code <= 77) return 'Snow Grains';
-  if (code <= 82) return 'Showers';
-  if (code <= 86) return 'Snow Shwrs';
-  if (code === 95) return 'T-Storm';
-  if (code <= 99) return 'T-Storm';
-  return 'Unknown';
-}
-
 function locationSuccess(pos) {
   // Construct Open-Meteo API URL
   var url = 'https://api.open-meteo.com/v1/forecast?' +
@@ -49,14 +32,18 @@ function locationSuccess(pos) {
       var temperature = Math.round(json.current.temperature_2m);
       console.log('Temperature is ' + temperature);
 
-      // Conditions from weather code
-      var conditions = weatherCodeToCondition(json.current.weather_code);
-      console.log('Conditions are ' + conditions);
+      // WMO weather code; the watch maps it to a condition in its own language
+      var weatherCode = json.current.weather_code;
+      console.log('Weather code is ' + weatherCode);
 
       // Assemble dictionary
+      // Coordinates in hundredths of a degree, cached on the watch for its
+      // own sunrise/sunset computation
       var dictionary = {
         'TEMPERATURE': temperature,
-        'CONDITIONS': conditions
+        'WEATHER_CODE': weatherCode,
+        'LATITUDE': Math.round(pos.coords.latitude * 100),
+        'LONGITUDE': Math.round(pos.coords.longitude * 100)
       };
 
       // Send to Pebble
@@ -84,13 +71,261 @@ function getWeather() {
   );
 }
 
+// HR event log pulled from the watch. Each event is 16 little-endian bytes:
+// seq (u32), start (u32), duration_sec (u16), min, max, delta, flags, 2 reserved
+var HR_LOG_EVENT_SIZE = 16;
+var HR_LOG_MAX_EVENTS = 60;
+var HR_LOG_FLAG_STAND = 0x01;
+
+function loadHrLog() {
+  try {
+    return JSON.parse(localStorage.getItem('hrLog')) || [];
+  } catch (err) {
+    return [];
+  }
+}
+
+function readUint(bytes, offset, length) {
+  var value = 0;
+  for (var i = length - 1; i >= 0; i--) {
+    value = (value * 256) + bytes[offset + i];
+  }
+  return value;
+}
+
+// Show the newest events in the settings page
+function updateHrLogConfig(log) {
+  var lines = log.slice(-10).reverse().map(function(event) {
+    var when = new Date(event.start * 1000).toLocaleString();
+    return when + ': ' + event.min + '-' + event.max + ' BPM, Δ' + event.delta +
+      ', ' + event.duration + 's' + (event.stand ? ' (stand)' : '');
+  });
+  var item = null;
+  clay.config.forEach(function(section) {
+    (section.items || []).forEach(function(entry) {
+      if (entry.id === 'HrEventLog') {
+        item = entry;
+      }
+    });
+  });
+  if (item && lines.length) {
+    item.defaultValue = lines.join('<br>');
+  }
+}
+
+function handleHrLogChunk(bytes) {
+  var log = loadHrLog();
+  for (var offset = 0; offset + HR_LOG_EVENT_SIZE <= bytes.length; offset += HR_LOG_EVENT_SIZE) {
+    var seq = readUint(bytes, offset, 4);
+    // The watch journal was reset (e.g. reinstall); start over
+    if (log.length && seq <= log[log.length - 1].seq) {
+      log = [];
+    }
+    log.push({
+      seq: seq,
+      start: readUint(bytes, offset + 4, 4),
+      duration: readUint(bytes, offset + 8, 2),
+      min: bytes[offset + 10],
+      max: bytes[offset + 11],
+      delta: bytes[offset + 12],
+      stand: (bytes[offset + 13] & HR_LOG_FLAG_STAND) !== 0
+    });
+  }
+  log = log.slice(-HR_LOG_MAX_EVENTS);
+  localStorage.setItem('hrLog', JSON.stringify(log));
+  updateHrLogConfig(log);
+
+  if (bytes.length === 0) {
+    console.log('HR log synced, ' + log.length + ' events stored');
+  }
+}
+
+function lastHrLogSeq() {
+  var log = loadHrLog();
+  return log.length ? log[log.length - 1].seq : 0;
+}
+
+// Ask the watch for every event newer than the last one we have
+function requestHrLog() {
+  Pebble.sendAppMessage({ 'HR_LOG_REQUEST': lastHrLogSeq() + 1 });
+}
+
+updateHrLogConfig(loadHrLog());
+
+// Second time zone. The watch has no zone database, so the phone resolves the
+// current UTC offset and the next DST change; the watch switches offsets on
+// its own and only asks again after crossing that change.
+var TZ_SCAN_DAYS = 400;
+var MS_PER_MINUTE = 60000;
+var MS_PER_DAY = 86400000;
+
+// UTC offset in minutes of the zone at the given time, via Intl
+function zoneOffsetMinutes(formatter, time) {
+  var match = formatter.format(new Date(time)).match(/(\d+)\/(\d+)\/(\d+),?\s+(\d+):(\d+)/);
+  var asUtc = Date.UTC(+match[3], match[1] - 1, +match[2], match[4] % 24, +match[5]);
+  return Math.round((asUtc - (Math.floor(time / MS_PER_MINUTE) * MS_PER_MINUTE)) / MS_PER_MINUTE);
+}
+
+// First minute after `from` with a different offset, or 0 within the scan range
+function nextOffsetChange(formatter, from, offset) {
+  for (var day = 1; day <= TZ_SCAN_DAYS; day++) {
+    var time = from + (day * MS_PER_DAY);
+    if (zoneOffsetMinutes(formatter, time) !== offset) {
+      var low = time - MS_PER_DAY;
+      var high = time;
+      while (high - low > MS_PER_MINUTE) {
+        var mid = Math.floor((low + high) / 2 / MS_PER_MINUTE) * MS_PER_MINUTE;
+        if (zoneOffsetMinutes(formatter, mid) === offset) {
+          low = mid;
+        } else {
+          high = mid;
+        }
+      }
+      return high;
+    }
+  }
+  return 0;
+}
+
+function zoneLabel(zone) {
+  return zone.split('/').pop().replace(/_/g, ' ').slice(0, 15);
+}
+
+function loadSettings() {
+  try {
+    return JSON.parse(localStorage.getItem('clay-settings')) || {};
+  } catch (err) {
+    return {};
+  }
+}
+
+// 32-bit FNV-1a of the stored Clay settings. The watch keeps the last hash it
+// received and reports it at launch, so unchanged settings are never resent.
+function settingsHash() {
+  var text = localStorage.getItem('clay-settings') || '';
+  var hash = 0x811c9dc5;
+  for (var i = 0; i < text.length; i++) {
+    hash ^= text.charCodeAt(i) & 0xff;
+    hash += (hash << 1) + (hash << 4) + (hash << 7) + (hash << 8) + (hash << 24);
+  }
+  return hash | 0;
+}
+
+function secondZoneDictionary() {
+  var settings = loadSettings();
+  var zone = (settings.SecondZone || '').trim();
+  var dictionary = { 'TZ_LABEL': '' };
+
+  if (zone) {
+    try {
+      var formatter = new Intl.DateTimeFormat('en-US', {
+        timeZone: zone, hour12: false, year: 'numeric', month: '2-digit',
+        day: '2-digit', hour: '2-digit', minute: '2-digit'
+      });
+      var now = Date.now();
+      var offset = zoneOffsetMinutes(formatter, now);
+      var change = nextOffsetChange(formatter, now, offset);
+      dictionary = {
+        'TZ_LABEL': zoneLabel(zone),
+        'TZ_OFFSET': offset,
+        'TZ_NEXT_CHANGE': change ? Math.floor(change / 1000) : 0,
+        'TZ_NEXT_OFFSET': change ? zoneOffsetMinutes(formatter, change) : offset
+      };
+    } catch (err) {
+      console.log('Unknown time zone ' + zone + ': ' + err);
+    }
+  }
+
+  return dictionary;
+}
+
+// The settings hash rides along so the watch knows which settings it has
+function sendSecondZone() {
+  var dictionary = secondZoneDictionary();
+  dictionary['SETTINGS_HASH'] = settingsHash();
+  Pebble.sendAppMessage(dictionary);
+}
+
+// Pushes every stored setting, for a watch that missed a change (e.g. it was
+// out of range when the settings page closed)
+function sendAllSettings() {
+  var dictionary = Clay.prepareSettingsForAppMessage(loadSettings());
+  var zone = secondZoneDictionary();
+  Object.keys(zone).forEach(function(key) {
+    dictionary[messageKeys[key]] = zone[key];
+  });
+  dictionary[messageKeys.SETTINGS_HASH] = settingsHash();
+  Pebble.sendAppMessage(dictionary);
+}
+
+// Launch handshake. The watch sends HELLO with what it already has; anything
+// missing or stale is sent back, and nothing when all is current.
+var PROTOCOL_VERSION = 1;
+// Used when the watch does not report its own refresh interval
+var WEATHER_DEFAULT_INTERVAL_SEC = 30 * 60;
+var HELLO_TIMEOUT_MS = 5000;
+var helloTimer = null;
+
+// Watches without the handshake get the full refresh
+function legacyRefresh() {
+  getWeather();
+  requestHrLog();
+  sendSecondZone();
+}
+
+function handleHello(payload) {
+  if (helloTimer) {
+    clearTimeout(helloTimer);
+    helloTimer = null;
+  }
+  if (payload['HELLO'] !== PROTOCOL_VERSION) {
+    legacyRefresh();
+    return;
+  }
+
+  // Only reported while a weather or sun slot is shown; -1 means none cached.
+  // The watch's interval follows its battery state. A REQUEST_WEATHER in the
+  // same message is a refresh it queued while the phone was unreachable.
+  var weatherAge = payload['WEATHER_AGE'];
+  var weatherInterval = payload['WEATHER_INTERVAL'] || WEATHER_DEFAULT_INTERVAL_SEC;
+  if (payload['REQUEST_WEATHER'] ||
+      (weatherAge !== undefined && (weatherAge < 0 || weatherAge >= weatherInterval))) {
+    getWeather();
+  }
+
+  if ((payload['SETTINGS_HASH'] | 0) !== settingsHash()) {
+    sendAllSettings();
+  } else if (payload['TZ_REQUEST']) {
+    sendSecondZone();
+  }
+
+  // A watch behind us was reset, so its journal restarts from 1
+  var watchLast = payload['HR_LOG_LAST'];
+  var last = lastHrLogSeq();
+  if (watchLast !== undefined && watchLast !== last) {
+    Pebble.sendAppMessage({ 'HR_LOG_REQUEST': watchLast > last ? last + 1 : 1 });
+  }
+}
+
 // Listen for when the watchface is opened
 Pebble.addEventListener('ready',
   function(e) {
     console.log('PebbleKit JS ready!');
 
-    // Get the initial weather
-    getWeather();
+    // The watch says hello on launch; fall back if it never does
+    helloTimer = setTimeout(function() {
+      helloTimer = null;
+      legacyRefresh();
+    }, HELLO_TIMEOUT_MS);
+  }
+);
+
+// Clay stores the new settings before this runs
+Pebble.addEventListener('webviewclosed',
+  function(e) {
+    if (e && e.response) {
+      sendSecondZone();
+    }
   }
 );
 
@@ -98,9 +333,19 @@ Pebble.addEventListener('ready',
 Pebble.addEventListener('appmessage',
   function(e) {
     console.log('AppMessage received!');
+    if (e.payload['HELLO'] !== undefined) {
+      handleHello(e.payload);
+      return;
+    }
     // Check if this is a weather refresh request
     if (e.payload['REQUEST_WEATHER']) {
       getWeather();
     }
+    if (e.payload['TZ_REQUEST']) {
+      sendSecondZone();
+    }
+    if (e.payload['HR_LOG_CHUNK'] !== undefined) {
+      handleHrLogChunk(e.payload['HR_LOG_CHUNK']);
+    }
   }
 );
@@ -0,0 +1,45 @@
+#pragma once
+
+// Timing helpers for the host benchmarks. Wall time comes from the monotonic
+// clock; cycles from the TSC on x86 and are reported as 0 elsewhere. Both are
+// host figures, useful for comparing implementations rather than predicting
+// watch timings.
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAS_CYCLES 1
+#else
+#define BENCH_HAS_CYCLES 0
+#endif
+
+typedef struct BenchClock {
+  uint64_t ns;
+  uint64_t cycles;
+} BenchClock;
+
+static inline BenchClock bench_now(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  BenchClock clock = { .ns = (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec };
+#if BENCH_HAS_CYCLES
+  clock.cycles = __rdtsc();
+#endif
+  return clock;
+}
+
+// Prints the per-call cost of `calls` calls made since start
+static inline void bench_report(const char *name, BenchClock start, uint64_t calls) {
+  BenchClock end = bench_now();
+  double ns = (double)(end.ns - start.ns) / (double)calls;
+  double cycles = (double)(end.cycles - start.cycles) / (double)calls;
+  printf("%-32s %8.1f ns/call %8.1f cycles/call\n", name, ns, cycles);
+}
+
+// Keeps results observable so the optimiser cannot drop the measured calls
+static volatile int64_t bench_sink;
@@ -0,0 +1,70 @@
+// Host microbenchmarks for the per-sample src/c/hr_analytics.c calls
+
+#include "bench.h"
+#include "hr_analytics.h"
+
+#define CALLS 2000000u
+#define T0 600000u
+
+// A plausible HR trace: a slow ramp with beat-to-beat jitter and the
+// occasional spike, one sample per second
+static int32_t prv_bpm(uint32_t index) {
+  int32_t bpm = 70 + (int32_t)((index / 30) % 40) + (int32_t)((index * 7919u) % 5);
+  return index % 97 == 0 ? bpm + 60 : bpm;
+}
+
+int main(void) {
+  printf("%u calls each, 1 sample per second\n", CALLS);
+
+  HrOutlierFilter filter;
+  hr_outlier_filter_init(&filter);
+  BenchClock start = bench_now();
+  for (uint32_t index = 0; index < CALLS; index++) {
+    bench_sink += hr_outlier_filter_accept(&filter, prv_bpm(index));
+  }
+  bench_report("hr_outlier_filter_accept", start, CALLS);
+
+  // Five-minute window, as the alert uses: the ring stays full, so every push
+  // also evicts
+  HrWindow window;
+  hr_window_init(&window, 300);
+  start = bench_now();
+  for (uint32_t index = 0; index < CALLS; index++) {
+    hr_window_push(&window, T0 + index, prv_bpm(index));
+  }
+  bench_report("hr_window_push", start, CALLS);
+
+  start = bench_now();
+  for (uint32_t index = 0; index < CALLS; index++) {
+    // Defeat hoisting of the pure call out of the loop
+    window.sum_ty += index & 1;
+    bench_sink += hr_window_slope_per_min(&window) + hr_window_mean(&window);
+  }
+  bench_report("hr_window_slope + mean", start, CALLS);
+
+  HrBlockWindows blocks;
+  HrBlock finished;
+  uint32_t skipped;
+  hr_blocks_init(&blocks);
+  start = bench_now();
+  for (uint32_t index = 0; index < CALLS; index++) {
+    bench_sink += hr_blocks_add(&blocks, T0 + index, prv_bpm(index), &finished, &skipped);
+  }
+  bench_report("hr_blocks_add", start, CALLS);
+
+  start = bench_now();
+  for (uint32_t index = 0; index < CALLS; index++) {
+    bench_sink += hr_blocks_query(&blocks, (index & 1) ? 60 : 300).count;
+  }
+  bench_report("hr_blocks_query (60 s / 5 min)", start, CALLS);
+
+  HrZoneClock clock = { 0 };
+  start = bench_now();
+  for (uint32_t index = 0; index < CALLS; index++) {
+    hr_zone_clock_add(&clock, T0 + index, prv_bpm(index), 62);
+  }
+  bench_sink += clock.seconds[HrZoneRest];
+  bench_report("hr_zone_clock_add", start, CALLS);
+
+  return 0;
+}
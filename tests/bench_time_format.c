@@ -0,0 +1,91 @@
+// Host benchmark for src/c/time_format.c against the strftime calls it
+// replaced. Output is first checked against strftime for every minute of 800
+// days; the per-tick cost then covers one clock and one date string. Code
+// size is reported by 'make -C tests bench' from a -Os object.
+
+#include "bench.h"
+#include "time_format.h"
+
+#include <string.h>
+
+#define DAYS 800
+#define MINUTES (DAYS * 24 * 60)
+// 2024-01-01 00:00 UTC, so the range covers a leap day
+#define START 1704067200
+
+// strftime has no hour without a leading zero; the watch strips it the same way
+static void prv_strftime_clock(char *buffer, size_t size, const struct tm *tm, bool is_24h) {
+  strftime(buffer, size, is_24h ? "%H:%M" : "%I:%M", tm);
+  if (!is_24h && buffer[0] == '0') {
+    memmove(buffer, buffer + 1, strlen(buffer));
+  }
+}
+
+static int prv_check_output(void) {
+  int mismatches = 0;
+  for (long minute = 0; minute < MINUTES; minute++) {
+    time_t now = START + (minute * 60);
+    struct tm tm;
+    gmtime_r(&now, &tm);
+
+    char expected[32];
+    char actual[32];
+    for (int is_24h = 0; is_24h <= 1; is_24h++) {
+      prv_strftime_clock(expected, sizeof(expected), &tm, is_24h);
+      time_format_clock(actual, sizeof(actual), tm.tm_hour, tm.tm_min, is_24h);
+      if (strcmp(expected, actual) != 0 && mismatches++ == 0) {
+        printf("clock mismatch at %ld: \"%s\" vs \"%s\"\n", (long)now, actual, expected);
+      }
+    }
+    strftime(expected, sizeof(expected), "%a %b %d", &tm);
+    time_format_date(actual, sizeof(actual), &tm, NULL, NULL);
+    if (strcmp(expected, actual) != 0 && mismatches++ == 0) {
+      printf("date mismatch at %ld: \"%s\" vs \"%s\"\n", (long)now, actual, expected);
+    }
+  }
+  return mismatches;
+}
+
+int main(void) {
+  int mismatches = prv_check_output();
+  printf("output vs strftime over %d days: %d mismatches\n", DAYS, mismatches);
+  if (mismatches) {
+    return 1;
+  }
+
+  // Broken-down times are prepared up front so only formatting is timed
+  enum { TICKS = 1440 };
+  static struct tm ticks[TICKS];
+  for (int index = 0; index < TICKS; index++) {
+    time_t now = START + (index * 60);
+    gmtime_r(&now, &ticks[index]);
+  }
+
+  char clock_text[TIME_FORMAT_CLOCK_SIZE];
+  char date_text[TIME_FORMAT_DATE_SIZE];
+  const uint32_t rounds = 1000;
+
+  BenchClock start = bench_now();
+  for (uint32_t round = 0; round < rounds; round++) {
+    for (int index = 0; index < TICKS; index++) {
+      const struct tm *tm = &ticks[index];
+      time_format_clock(clock_text, sizeof(clock_text), tm->tm_hour, tm->tm_min, true);
+      time_format_date(date_text, sizeof(date_text), tm, NULL, NULL);
+      bench_sink += clock_text[4] + date_text[0];
+    }
+  }
+  bench_report("time_format (clock + date)", start, (uint64_t)rounds * TICKS);
+
+  start = bench_now();
+  for (uint32_t round = 0; round < rounds; round++) {
+    for (int index = 0; index < TICKS; index++) {
+      const struct tm *tm = &ticks[index];
+      strftime(clock_text, sizeof(clock_text), "%H:%M", tm);
+      strftime(date_text, sizeof(date_text), "%a %b %d", tm);
+      bench_sink += clock_text[4] + date_text[0];
+    }
+  }
+  bench_report("strftime (clock + date)", start, (uint64_t)rounds * TICKS);
+
+  return 0;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+// Minimal assertion helpers for the host tests. A failed check prints its
+// location and the test keeps going; main returns the failure count.
+
+#include <stdio.h>
+
+static int s_check_failures;
+
+#define CHECK(cond)                                                         \
+  do {                                                                      \
+    if (!(cond)) {                                                          \
+      printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond);       \
+      s_check_failures++;                                                   \
+    }                                                                       \
+  } while (0)
+
+#define CHECK_EQ(actual, expected)                                          \
+  do {                                                                      \
+    long long check_actual_ = (long long)(actual);                          \
+    long long check_expected_ = (long long)(expected);                      \
+    if (check_actual_ != check_expected_) {                                 \
+      printf("%s:%d: %s == %lld, expected %lld\n", __FILE__, __LINE__,      \
+             #actual, check_actual_, check_expected_);                      \
+      s_check_failures++;                                                   \
+    }                                                                       \
+  } while (0)
+
+#define RUN_TEST(test)                                                      \
+  do {                                                                      \
+    int check_before_ = s_check_failures;                                   \
+    test();                                                                 \
+    printf("%-44s %s\n", #test, s_check_failures == check_before_ ? "ok" : "FAILED"); \
+  } while (0)
@@ -0,0 +1,246 @@
+// Host tests for src/c/hr_analytics.c
+
+#include "check.h"
+#include "hr_analytics.h"
+
+#include <math.h>
+
+// Minute-aligned start time, well clear of block id 0 (the "no block yet" id)
+#define T0 600000u
+
+// Small deterministic generator so runs are repeatable
+static uint32_t s_seed = 12345;
+
+static int32_t prv_rand(int32_t range) {
+  s_seed = (s_seed * 1103515245u) + 12345u;
+  return (int32_t)((s_seed >> 16) % (uint32_t)range);
+}
+
+static void test_outlier_filter_rejects_spikes(void) {
+  HrOutlierFilter filter;
+  hr_outlier_filter_init(&filter);
+
+  // Too little history to judge: even a wild value passes
+  CHECK(hr_outlier_filter_accept(&filter, 70));
+  CHECK(hr_outlier_filter_accept(&filter, 180));
+  hr_outlier_filter_init(&filter);
+
+  static const int32_t steady[] = { 70, 72, 71, 70, 72 };
+  for (int index = 0; index < 5; index++) {
+    CHECK(hr_outlier_filter_accept(&filter, steady[index]));
+  }
+
+  // A lone spike is dropped, normal variation is not
+  CHECK(!hr_outlier_filter_accept(&filter, 140));
+  CHECK_EQ(filter.rejected, 1);
+  CHECK(hr_outlier_filter_accept(&filter, 72 + HR_OUTLIER_MIN_JUMP_BPM - 1));
+  CHECK_EQ(filter.rejected, 1);
+}
+
+static void test_outlier_filter_accepts_sustained_step(void) {
+  HrOutlierFilter filter;
+  hr_outlier_filter_init(&filter);
+  for (int index = 0; index < HR_OUTLIER_RING_SIZE; index++) {
+    hr_outlier_filter_accept(&filter, 70);
+  }
+
+  // The step is accepted once it fills more than half the ring
+  CHECK(!hr_outlier_filter_accept(&filter, 110));
+  CHECK(!hr_outlier_filter_accept(&filter, 110));
+  CHECK(hr_outlier_filter_accept(&filter, 110));
+  CHECK(hr_outlier_filter_accept(&filter, 110));
+}
+
+/**
+ * Two-pass double-precision least squares over the samples the window should
+ * still hold: those no older than max_age_sec, at most HR_SAMPLE_BUFFER_SIZE.
+ * The slope is 0 below HR_SLOPE_MIN_SPAN_SEC, as in the module.
+ */
+static void prv_reference_fit(const uint32_t *times, const int32_t *values, int count,
+                              uint32_t max_age_sec, double *slope_per_min, double *mean) {
+  uint32_t now = times[count - 1];
+  int first = count - 1;
+  while (first > 0 && count - first < HR_SAMPLE_BUFFER_SIZE &&
+         now - times[first - 1] <= max_age_sec) {
+    first--;
+  }
+
+  int n = count - first;
+  double mean_t = 0;
+  double mean_y = 0;
+  for (int index = first; index < count; index++) {
+    mean_t += times[index];
+    mean_y += values[index];
+  }
+  mean_t /= n;
+  mean_y /= n;
+
+  double covariance = 0;
+  double variance = 0;
+  for (int index = first; index < count; index++) {
+    covariance += (times[index] - mean_t) * (values[index] - mean_y);
+    variance += (times[index] - mean_t) * (times[index] - mean_t);
+  }
+  // The module reports no trend over too short a span
+  bool spans = now - times[first] >= HR_SLOPE_MIN_SPAN_SEC;
+  *slope_per_min = spans && variance > 0 ? (covariance / variance) * 60 : 0;
+  *mean = mean_y;
+}
+
+static void test_window_matches_reference_fit(void) {
+  enum { SAMPLES = 2000 };
+  static uint32_t times[SAMPLES];
+  static int32_t values[SAMPLES];
+  const uint32_t max_age_sec = 600;
+
+  HrWindow window;
+  hr_window_init(&window, max_age_sec);
+
+  // Irregular 1-9 s spacing over several hours exercises age eviction, the
+  // full ring and the origin rebase; the trend reverses every ~20 minutes
+  uint32_t now = T0;
+  int mismatches = 0;
+  for (int index = 0; index < SAMPLES; index++) {
+    now += 1 + (uint32_t)prv_rand(9);
+    int32_t trend = (index / 150) % 2 ? 150 - (index % 150) / 3 : 100 + (index % 150) / 3;
+    times[index] = now;
+    values[index] = trend + prv_rand(7) - 3;
+    hr_window_push(&window, now, values[index]);
+
+    if (index < 2) {
+      continue;
+    }
+    double slope;
+    double mean;
+    prv_reference_fit(times, values, index + 1, max_age_sec, &slope, &mean);
+    if (hr_window_slope_per_min(&window) != (int32_t)lround(slope) ||
+        hr_window_mean(&window) != (int32_t)floor(mean)) {
+      if (mismatches++ == 0) {
+        printf("sample %d: slope %d vs %.3f, mean %d vs %.3f\n", index,
+               (int)hr_window_slope_per_min(&window), slope, (int)hr_window_mean(&window), mean);
+      }
+    }
+  }
+  CHECK_EQ(mismatches, 0);
+  CHECK(window.count <= HR_SAMPLE_BUFFER_SIZE);
+}
+
+static void test_window_needs_span_for_slope(void) {
+  HrWindow window;
+  hr_window_init(&window, 300);
+  hr_window_push(&window, T0, 60);
+  hr_window_push(&window, T0 + 5, 70);
+  CHECK_EQ(hr_window_slope_per_min(&window), 0);
+
+  // Three samples but under HR_SLOPE_MIN_SPAN_SEC apart
+  hr_window_push(&window, T0 + 10, 80);
+  CHECK_EQ(hr_window_slope_per_min(&window), 0);
+
+  // 2 BPM per second = 120 BPM per minute
+  hr_window_push(&window, T0 + 15, 90);
+  CHECK_EQ(hr_window_slope_per_min(&window), 120);
+  CHECK_EQ(hr_window_mean(&window), 75);
+
+  // Everything ages out but the new sample
+  hr_window_push(&window, T0 + 1000, 50);
+  CHECK_EQ(window.count, 1);
+  CHECK_EQ(hr_window_mean(&window), 50);
+}
+
+static void test_blocks_roll_over_ten_sec_and_minute(void) {
+  HrBlockWindows blocks;
+  HrBlock finished = { 0 };
+  uint32_t skipped = 99;
+  hr_blocks_init(&blocks);
+
+  // Two samples in the first 10 s block, one in the next
+  CHECK(!hr_blocks_add(&blocks, T0, 60, &finished, &skipped));
+  CHECK(!hr_blocks_add(&blocks, T0 + 9, 70, &finished, &skipped));
+  CHECK(!hr_blocks_add(&blocks, T0 + 10, 90, &finished, &skipped));
+
+  HrBlock last_10 = hr_blocks_query(&blocks, 10);
+  CHECK_EQ(last_10.count, 1);
+  CHECK_EQ(last_10.min, 90);
+  CHECK_EQ(hr_block_spread(&last_10), 0);
+
+  HrBlock last_20 = hr_blocks_query(&blocks, 20);
+  CHECK_EQ(last_20.count, 3);
+  CHECK_EQ(last_20.min, 60);
+  CHECK_EQ(last_20.max, 90);
+  CHECK_EQ(hr_block_mean(&last_20), 73);
+  CHECK_EQ(hr_block_spread(&last_20), 30);
+
+  // The rest of the minute, then the first sample of the next one closes it
+  CHECK(!hr_blocks_add(&blocks, T0 + 55, 80, &finished, &skipped));
+  CHECK(hr_blocks_add(&blocks, T0 + 60, 100, &finished, &skipped));
+  CHECK_EQ(skipped, 0);
+  CHECK_EQ(finished.id, T0 / 60);
+  CHECK_EQ(finished.count, 4);
+  CHECK_EQ(finished.sum, 60 + 70 + 90 + 80);
+  CHECK_EQ(finished.min, 60);
+  CHECK_EQ(finished.max, 90);
+
+  // Short queries slide across the minute boundary block by block
+  CHECK_EQ(hr_blocks_query(&blocks, 10).count, 1);
+  HrBlock last_60 = hr_blocks_query(&blocks, 60);
+  CHECK_EQ(last_60.count, 3);
+  CHECK_EQ(last_60.min, 80);
+
+  // The 2 minute query merges the open block with both minute blocks
+  HrBlock last_2_min = hr_blocks_query(&blocks, 120);
+  CHECK_EQ(last_2_min.count, 5);
+  CHECK_EQ(last_2_min.max, 100);
+
+  // Three minutes without data: two empty minutes are reported
+  CHECK(hr_blocks_add(&blocks, T0 + 240, 65, &finished, &skipped));
+  CHECK_EQ(skipped, 2);
+  CHECK_EQ(finished.id, (T0 + 60) / 60);
+  CHECK_EQ(finished.count, 1);
+
+  // Only the minute ring's depth is queried, and stale slots are ignored
+  HrBlock last_5_min = hr_blocks_query(&blocks, 300);
+  CHECK_EQ(last_5_min.count, 6);
+  HrBlock last_hour = hr_blocks_query(&blocks, 3600);
+  CHECK_EQ(last_hour.count, last_5_min.count);
+  CHECK_EQ(hr_blocks_query(&blocks, 60).count, 1);
+}
+
+static void test_zone_accounting(void) {
+  // Baseline 60: elevated from 72, high from 90
+  CHECK_EQ(hr_zone_classify(71, 60), HrZoneRest);
+  CHECK_EQ(hr_zone_classify(72, 60), HrZoneElevated);
+  CHECK_EQ(hr_zone_classify(90, 60), HrZoneHigh);
+  // No baseline: fixed thresholds
+  CHECK_EQ(hr_zone_classify(HR_ZONE_ELEVATED_DEFAULT_BPM - 1, 0), HrZoneRest);
+  CHECK_EQ(hr_zone_classify(HR_ZONE_ELEVATED_DEFAULT_BPM, 0), HrZoneElevated);
+  CHECK_EQ(hr_zone_classify(HR_ZONE_HIGH_DEFAULT_BPM, 0), HrZoneHigh);
+
+  HrZoneClock clock = { 0 };
+  hr_zone_clock_add(&clock, T0, 60, 60);
+  hr_zone_clock_add(&clock, T0 + 10, 80, 60);
+  hr_zone_clock_add(&clock, T0 + 30, 100, 60);
+  hr_zone_clock_add(&clock, T0 + 40, 60, 60);
+  CHECK_EQ(clock.seconds[HrZoneRest], 10);
+  CHECK_EQ(clock.seconds[HrZoneElevated], 20);
+  CHECK_EQ(clock.seconds[HrZoneHigh], 10);
+
+  // A gap past HR_ZONE_MAX_GAP_SEC is missing data, not rest
+  hr_zone_clock_add(&clock, T0 + 40 + HR_ZONE_MAX_GAP_SEC + 1, 60, 60);
+  CHECK_EQ(clock.seconds[HrZoneRest], 10);
+  // Time going backwards is ignored
+  hr_zone_clock_add(&clock, T0, 60, 60);
+  CHECK_EQ(clock.seconds[HrZoneRest], 10);
+
+  CHECK_EQ(hr_percent_above_baseline(75, 60), 25);
+  CHECK_EQ(hr_percent_above_baseline(75, 0), 0);
+}
+
+int main(void) {
+  RUN_TEST(test_outlier_filter_rejects_spikes);
+  RUN_TEST(test_outlier_filter_accepts_sustained_step);
+  RUN_TEST(test_window_matches_reference_fit);
+  RUN_TEST(test_window_needs_span_for_slope);
+  RUN_TEST(test_blocks_roll_over_ten_sec_and_minute);
+  RUN_TEST(test_zone_accounting);
+  return s_check_failures != 0;
+}
@@ -0,0 +1,184 @@
+#!/usr/bin/env python3
+"""Writes the per-platform feature profile header, features.auto.h.
+
+Each profile decides which optional subsystems, buffer sizes and fonts a
+platform is built with, so the 24 KB Aplite app stays lean while the larger
+watches get everything. wscript generates one header per target platform in
+that platform's build directory and adds the directory to its include path.
+Sources that use a value include the header directly, so waf tracks it as a
+dependency.
+
+Every platform in package.json's targetPlatforms needs a profile here. The
+weather icon resources' targetPlatforms are kept in step with
+FEATURE_WEATHER_ICONS so platforms without the feature do not carry them;
+tools/sync_resources.py applies this and the date font entries below to
+package.json.
+
+The display sizes pick each platform's resource variants. One FONT_JERSEY_<n>
+entry per DATE_FONT_SIZE is generated in package.json, limited to the
+platforms using it. tools/make_digit_atlas.py writes a ~<platform> tagged
+TIME_DIGITS file for each platform off the default TIME_DIGITS_SIZE, and the
+BT_ICON_SIZE icons are the ~<platform> tagged images in resources/images.
+"""
+
+import io
+import json
+import os
+
+# Macro name -> value. Booleans become 1/0.
+PROFILES = {
+    # 24 KB of app RAM, no draw commands and no Quick View
+    'aplite': {
+        'FEATURE_WEATHER_ICONS': False,
+        'FEATURE_QUICK_VIEW': False,
+        'FEATURE_SECOND_ZONE': False,
+        'FEATURE_SMALL_SLOT_FONTS': False,
+        'TEXT_FIT_CACHE_SIZE': 4,
+    },
+    'basalt': {},
+    'chalk': {},
+    'diorite': {},
+    # 200x228
+    'emery': {
+        'TIME_DIGITS_SIZE': 72,
+        'TIME_SPRITES_MAX_BYTES': 2048,
+        'DATE_FONT_SIZE': 30,
+        'BT_ICON_SIZE': 40,
+    },
+    'flint': {},
+    # 260x260 round
+    'gabbro': {
+        'TIME_DIGITS_SIZE': 72,
+        'TIME_SPRITES_MAX_BYTES': 2048,
+        'DATE_FONT_SIZE': 30,
+        'BT_ICON_SIZE': 40,
+    },
+}
+
+DEFAULTS = {
+    'FEATURE_WEATHER_ICONS': True,
+    'FEATURE_QUICK_VIEW': True,
+    'FEATURE_SECOND_ZONE': True,
+    # Slots step down to a 14 px Gothic before abbreviating
+    'FEATURE_SMALL_SLOT_FONTS': True,
+    'TEXT_FIT_CACHE_SIZE': 8,
+    # Sized for the 144x168 and 180x180 displays
+    'TIME_DIGITS_SIZE': 56,
+    'TIME_SPRITES_MAX_BYTES': 1024,
+    'DATE_FONT_SIZE': 24,
+    'BT_ICON_SIZE': 30,
+}
+
+
+WEATHER_ICON_PREFIX = 'IMAGE_WX_'
+DATE_FONT_PREFIX = 'FONT_JERSEY_'
+
+
+def _profile(platform):
+    if platform not in PROFILES:
+        raise ValueError('no feature profile for platform %s' % platform)
+    profile = dict(DEFAULTS)
+    profile.update(PROFILES[platform])
+    return profile
+
+
+def profile_value(platform, name):
+    """One value of a platform's profile, defaults applied."""
+    return _profile(platform)[name]
+
+
+def platforms_by_value(platforms, name):
+    """Groups platforms by their value of one profile entry, in order."""
+    groups = {}
+    for platform in platforms:
+        groups.setdefault(profile_value(platform, name), []).append(platform)
+    return groups
+
+
+def _render(platform):
+    profile = _profile(platform)
+    lines = [
+        '// Generated by tools/gen_features.py for %s. Do not edit.' % platform,
+        '#pragma once',
+        '',
+    ]
+    for name in sorted(profile):
+        value = profile[name]
+        if isinstance(value, bool):
+            value = int(value)
+        lines.append('#define %s %d' % (name, value))
+    return '\n'.join(lines) + '\n'
+
+
+def write_features(platform, directory):
+    """Writes directory/features.auto.h, touching it only when it changes."""
+    path = os.path.join(directory, 'features.auto.h')
+    text = _render(platform)
+    if os.path.exists(path):
+        with open(path) as existing:
+            if existing.read() == text:
+                return path
+    if not os.path.isdir(directory):
+        os.makedirs(directory)
+    with open(path, 'w') as output:
+        output.write(text)
+    return path
+
+
+def _sync_date_fonts(media_list, target_platforms):
+    """Keeps one date font entry per DATE_FONT_SIZE, each limited to the
+    platforms that load it, so no pack carries a size it never uses."""
+    fonts = [media for media in media_list if media['name'].startswith(DATE_FONT_PREFIX)]
+    if not fonts:
+        return False
+    template = fonts[0]
+
+    wanted = []
+    groups = platforms_by_value(target_platforms, 'DATE_FONT_SIZE')
+    for size in sorted(groups):
+        name = '%s%d' % (DATE_FONT_PREFIX, size)
+        media = next((font for font in fonts if font['name'] == name), None)
+        if media is None:
+            media = dict(template)
+            media['name'] = name
+        media = dict(media)
+        media['targetPlatforms'] = groups[size]
+        wanted.append(media)
+
+    if wanted == fonts:
+        return False
+    index = media_list.index(template)
+    media_list[:] = [media for media in media_list if media not in fonts]
+    media_list[index:index] = wanted
+    return True
+
+
+def sync_resources(root='.', check=False):
+    """Limits the weather icons to platforms whose profile draws them and
+    generates the per-size date font entries. Returns whether package.json
+    was (or, with check, would be) changed."""
+    package_path = os.path.join(root, 'package.json')
+    with io.open(package_path, encoding='utf-8') as handle:
+        package = json.load(handle)
+
+    target_platforms = package['pebble']['targetPlatforms']
+    media_list = package['pebble']['resources']['media']
+    platforms = [platform for platform in target_platforms
+                 if _profile(platform)['FEATURE_WEATHER_ICONS']]
+    changed = _sync_date_fonts(media_list, target_platforms)
+    for media in media_list:
+        if media['name'].startswith(WEATHER_ICON_PREFIX) and media.get('targetPlatforms') != platforms:
+            media['targetPlatforms'] = platforms
+            changed = True
+    if changed and not check:
+        text = json.dumps(package, indent=4, ensure_ascii=False) + '\n'
+        with io.open(package_path, 'w', encoding='utf-8') as output:
+            output.write(text)
+    return changed
+
+
+if __name__ == '__main__':
+    import sys
+    if len(sys.argv) != 3:
+        sys.exit('usage: gen_features.py <platform> <output-dir>')
+    print(write_features(sys.argv[1], sys.argv[2]))
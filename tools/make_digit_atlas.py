@@ -0,0 +1,110 @@
+#!/usr/bin/env python3
+"""Rasterises the time digits into the TIME_DIGITS raw resource.
+
+The Jersey glyphs for 0-9 and ':' are rendered without anti-aliasing at each
+platform's TIME_DIGITS_SIZE from tools/gen_features.py, the way the SDK's font
+generator rasterises them, and packed side by side into one 1-bit strip. The watch
+copies these bits straight into the frame buffer instead of going through the
+font engine.
+
+Layout (little-endian):
+  u8 version, u8 glyph_count, u8 height, u8 top, u16 row_bytes, u16 reserved
+  glyph_count x { char code, u8 width, u16 x, i8 bearing, u8 advance }
+  height rows of row_bytes, pixel x at bit (x % 8) of byte x / 8, 1 = ink
+
+`top` is the first inked row below the top of the line, so the digits sit
+where a TextLayer with the font would have drawn them.
+
+time-digits.bin holds the default size. Platforms with another size get a
+time-digits~<platform>.bin variant, which the SDK packs in place of the
+untagged file, so each platform carries only the size it draws.
+
+Needs Pillow. Run from the project root after changing the font or a size:
+
+    python3 tools/make_digit_atlas.py
+"""
+
+import glob
+import io
+import json
+import os
+import struct
+
+from PIL import Image, ImageDraw, ImageFont
+
+from gen_features import DEFAULTS, platforms_by_value, profile_value
+
+VERSION = 1
+FONT = os.path.join('resources', 'fonts', 'Jersey10-Regular.ttf')
+CHARACTERS = '0123456789:'
+TARGET = os.path.join('resources', 'data', 'time-digits%s.bin')
+
+
+def _render(font, character):
+    left, top, right, bottom = font.getbbox(character, mode='1')
+    image = Image.new('1', (right - left, bottom - top), 0)
+    draw = ImageDraw.Draw(image)
+    draw.fontmode = '1'
+    draw.text((-left, -top), character, font=font, fill=1)
+    return image, left, top, bottom, int(round(font.getlength(character, mode='1')))
+
+
+def _atlas(root, size):
+    font = ImageFont.truetype(os.path.join(root, FONT), size)
+    glyphs = [(character,) + _render(font, character) for character in CHARACTERS]
+
+    top = min(glyph[3] for glyph in glyphs)
+    bottom = max(glyph[4] for glyph in glyphs)
+    height = bottom - top
+    width = sum(glyph[1].width for glyph in glyphs)
+    row_bytes = (width + 7) // 8
+
+    rows = [bytearray(row_bytes) for _ in range(height)]
+    entries = b''
+    x = 0
+    for character, image, left, glyph_top, _, advance in glyphs:
+        for row in range(image.height):
+            for column in range(image.width):
+                if image.getpixel((column, row)):
+                    pixel = x + column
+                    rows[glyph_top - top + row][pixel // 8] |= 1 << (pixel % 8)
+        entries += struct.pack('<cBHbB', character.encode('ascii'), image.width, x, left, advance)
+        x += image.width
+
+    header = struct.pack('<BBBBHH', VERSION, len(glyphs), height, top, row_bytes, 0)
+    return header + entries + b''.join(bytes(row) for row in rows)
+
+
+def make_atlases(root='.'):
+    """Writes the default atlas and one tagged variant per platform drawing
+    another size. Returns {path: size in bytes}."""
+    with io.open(os.path.join(root, 'package.json'), encoding='utf-8') as handle:
+        platforms = json.load(handle)['pebble']['targetPlatforms']
+
+    atlases = {}
+    default_size = DEFAULTS['TIME_DIGITS_SIZE']
+    for size, group in sorted(platforms_by_value(platforms, 'TIME_DIGITS_SIZE').items()):
+        data = _atlas(root, size)
+        for platform in group:
+            # TIME_SPRITES_MAX_BYTES sizes the watch's static buffer
+            limit = profile_value(platform, 'TIME_SPRITES_MAX_BYTES')
+            if len(data) > limit:
+                raise ValueError('%s: atlas is %d bytes, over the %d-byte limit'
+                                 % (platform, len(data), limit))
+        tags = [''] if size == default_size else ['~' + platform for platform in group]
+        for tag in tags:
+            atlases[TARGET % tag] = data
+
+    # Drop variants left over from platforms back on the default size
+    for path in glob.glob(os.path.join(root, TARGET % '~*')):
+        if os.path.relpath(path, root) not in atlases:
+            os.remove(path)
+    for path, data in atlases.items():
+        with open(os.path.join(root, path), 'wb') as output:
+            output.write(data)
+    return {path: len(data) for path, data in atlases.items()}
+
+
+if __name__ == '__main__':
+    for path, size in sorted(make_atlases().items()):
+        print('%s: %d bytes' % (path, size))
@@ -0,0 +1,81 @@
+#!/usr/bin/env python3
+"""Writes the weather condition icons as Pebble Draw Command images (PDC).
+
+Each icon is a handful of paths and circles on a 20x20 view box, drawn in
+white; the watch re-tints them to the text colour at load time. Output goes
+to resources/icons/wx-<name>.pdc.
+
+Run from the project root after editing a shape:
+
+    python3 tools/make_weather_icons.py
+"""
+
+import os
+import struct
+
+VIEW_BOX = (20, 20)
+WHITE = 0xFF
+CLEAR = 0x00
+
+TYPE_PATH = 1
+TYPE_CIRCLE = 2
+
+
+def path(points, closed=False, stroke=2, fill=False):
+    return (TYPE_PATH, points, not closed, stroke, fill)
+
+
+def circle(center, radius, stroke=1, fill=True):
+    return (TYPE_CIRCLE, [center], radius, stroke, fill)
+
+
+def _cloud(top):
+    # Cloud outline; `top` shifts it up to leave room for precipitation
+    outline = [(3, 15), (3, 12), (5, 10), (7, 10), (8, 7), (11, 5), (14, 6), (15, 9),
+               (17, 10), (18, 12), (18, 15)]
+    return path([(x, y - top) for x, y in outline], closed=True)
+
+
+def _sun():
+    commands = [circle((10, 10), 4)]
+    rays = [((10, 1), (10, 3)), ((10, 17), (10, 19)), ((1, 10), (3, 10)), ((17, 10), (19, 10)),
+            ((4, 4), (5, 5)), ((15, 15), (16, 16)), ((4, 16), (5, 15)), ((15, 5), (16, 4))]
+    commands += [path(list(ray), stroke=1) for ray in rays]
+    return commands
+
+
+ICONS = {
+    'clear': _sun(),
+    'cloudy': [_cloud(0)],
+    'fog': [path([(2, 6), (15, 6)]), path([(5, 10), (18, 10)]), path([(2, 14), (15, 14)])],
+    'drizzle': [_cloud(4)] + [circle((x, 16), 1) for x in (6, 10, 14)],
+    'rain': [_cloud(4)] + [path([(x, 14), (x - 2, 18)]) for x in (7, 11, 15)],
+    'snow': [_cloud(4)] + [circle((x, y), 1) for x, y in ((6, 15), (10, 18), (14, 15))],
+    'storm': [_cloud(4), path([(11, 11), (7, 16), (10, 16), (8, 19), (14, 14), (11, 14), (13, 11)],
+                              closed=True, stroke=1, fill=True)],
+}
+
+
+def _command(command):
+    kind, points, open_or_radius, stroke, fill = command
+    header = struct.pack('<BBBBBHH', kind, 0, WHITE, stroke, WHITE if fill else CLEAR,
+                         int(open_or_radius), len(points))
+    return header + b''.join(struct.pack('<hh', x, y) for x, y in points)
+
+
+def encode(commands):
+    body = struct.pack('<BBhhH', 1, 0, VIEW_BOX[0], VIEW_BOX[1], len(commands))
+    body += b''.join(_command(command) for command in commands)
+    return b'PDCI' + struct.pack('<I', len(body)) + body
+
+
+def main():
+    for name, commands in sorted(ICONS.items()):
+        target = os.path.join('resources', 'icons', 'wx-%s.pdc' % name)
+        with open(target, 'wb') as output:
+            output.write(encode(commands))
+        print('%s: %d bytes' % (target, os.path.getsize(target)))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,107 @@
+#!/usr/bin/env python3
+"""Packs resources/data/strings.json into the STRINGS raw resource.
+
+Layout (little-endian):
+  u8 version, u8 language_count, u8 string_count, u8 reserved
+  language_count x { char code[2], u16 offset, u16 length }
+  one block per language: string_count NUL-terminated UTF-8 strings
+
+The string order must match L10nString in src/c/l10n.h. The characterRegex of
+every date font size in package.json is derived from the day and month names
+so the font subsets always cover the tables.
+
+Run tools/sync_resources.py from the project root after editing strings.json
+and commit the results; the build only checks that they are current.
+"""
+
+import io
+import json
+import os
+import re
+import struct
+
+VERSION = 1
+CONDITIONS = [
+    'clear', 'cloudy', 'fog', 'drizzle', 'freezing_drizzle', 'rain', 'freezing_rain',
+    'snow', 'snow_grains', 'showers', 'snow_showers', 'thunderstorm', 'unknown',
+]
+# L10N_BLOCK_MAX in src/c/l10n.h
+BLOCK_MAX = 256
+# One entry per size, generated by tools/gen_features.py
+DATE_FONT_PREFIX = 'FONT_JERSEY_'
+DATE_EXTRA_CHARS = ' 0123456789'
+
+
+def _strings_for(language, table):
+    days = table['days']
+    months = table['months']
+    if len(days) != 7 or len(months) != 12:
+        raise ValueError('%s: expected 7 days and 12 months' % language)
+    conditions = [table['conditions'][key] for key in CONDITIONS]
+    return days + months + conditions + [table['loading']]
+
+
+def _character_regex(chars):
+    return '[' + ''.join(re.escape(char) for char in sorted(chars)) + ']'
+
+
+def _write_if_changed(path, data, check=False):
+    """Returns whether path differs from data, writing it unless check."""
+    if os.path.exists(path):
+        with open(path, 'rb') as existing:
+            if existing.read() == data:
+                return False
+    if not check:
+        with open(path, 'wb') as output:
+            output.write(data)
+    return True
+
+
+def pack_strings(root='.', check=False):
+    """Packs the string tables and updates the date fonts' characterRegex.
+    Returns the paths that were (or, with check, would be) changed."""
+    source = os.path.join(root, 'resources', 'data', 'strings.json')
+    target = os.path.join(root, 'resources', 'data', 'strings.bin')
+    package_path = os.path.join(root, 'package.json')
+
+    with io.open(source, encoding='utf-8') as handle:
+        tables = json.load(handle)
+
+    languages = sorted(tables, key=lambda code: (code != 'en', code))
+    blocks = []
+    date_chars = set(DATE_EXTRA_CHARS)
+    string_count = None
+    for language in languages:
+        if len(language) != 2:
+            raise ValueError('language codes must be two letters: %s' % language)
+        strings = _strings_for(language, tables[language])
+        string_count = len(strings)
+        block = b''.join(text.encode('utf-8') + b'\0' for text in strings)
+        if len(block) > BLOCK_MAX:
+            raise ValueError('%s: %d bytes exceeds the %d-byte block limit'
+                             % (language, len(block), BLOCK_MAX))
+        blocks.append(block)
+        for name in tables[language]['days'] + tables[language]['months']:
+            date_chars.update(name)
+
+    header = struct.pack('<BBBB', VERSION, len(languages), string_count, 0)
+    offset = len(header) + (6 * len(languages))
+    directory = b''
+    for language, block in zip(languages, blocks):
+        directory += struct.pack('<2sHH', language.encode('ascii'), offset, len(block))
+        offset += len(block)
+    changed = []
+    if _write_if_changed(target, header + directory + b''.join(blocks), check):
+        changed.append(target)
+
+    with io.open(package_path, encoding='utf-8') as handle:
+        package = json.load(handle)
+    regex = _character_regex(date_chars)
+    for media in package['pebble']['resources']['media']:
+        if media['name'].startswith(DATE_FONT_PREFIX):
+            media['characterRegex'] = regex
+    text = json.dumps(package, indent=4, ensure_ascii=False) + '\n'
+    if _write_if_changed(package_path, text.encode('utf-8'), check):
+        changed.append(package_path)
+
+    return changed
@@ -0,0 +1,42 @@
+#!/usr/bin/env python3
+"""Regenerates the checked-in files derived from the profiles and strings.
+
+- package.json: weather icon targetPlatforms and the per-size date font
+  entries (tools/gen_features.py)
+- resources/data/strings.bin and the date fonts' characterRegex
+  (tools/pack_strings.py)
+
+Run from the project root after editing a profile or strings.json, and commit
+the result. wscript runs the same steps with check=True and stops the build
+when anything is stale, so a build never rewrites tracked files.
+
+    python3 tools/sync_resources.py [--check]
+"""
+
+import os
+import sys
+
+from gen_features import sync_resources
+from pack_strings import pack_strings
+
+
+def sync_all(root='.', check=False):
+    """Returns the paths that were (or, with check, would be) changed."""
+    stale = []
+    # Font entries first, so their characterRegex is filled in by pack_strings
+    if sync_resources(root, check):
+        stale.append(os.path.join(root, 'package.json'))
+    for path in pack_strings(root, check):
+        if path not in stale:
+            stale.append(path)
+    return stale
+
+
+if __name__ == '__main__':
+    check = '--check' in sys.argv[1:]
+    stale = sync_all('.', check)
+    for path in stale:
+        print(('stale: %s' if check else 'updated: %s') % path)
+    if not stale:
+        print('generated resources up to date')
+    sys.exit(1 if check and stale else 0)